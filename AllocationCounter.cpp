@@ -0,0 +1,78 @@
+#include "AllocationCounter.h"
+#include <stdlib.h>
+#include <new>
+
+static volatile unsigned long allocations = 0;
+
+#ifdef COUNT_ALLOCATIONS
+
+#if __cplusplus >= 201103L
+#define NEW_THROWS
+#else
+#define NEW_THROWS throw(std::bad_alloc)
+#endif
+
+static void *countedAllocate(size_t size)
+{
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+	__sync_fetch_and_add(&allocations, 1);
+#else
+	allocations++;
+#endif
+	void *p = malloc(size ? size : 1);
+	if (!p)
+		throw std::bad_alloc();
+	return p;
+}
+
+void *operator new(size_t size) NEW_THROWS
+{
+	return countedAllocate(size);
+}
+
+void *operator new[](size_t size) NEW_THROWS
+{
+	return countedAllocate(size);
+}
+
+void operator delete(void *p) throw()
+{
+	free(p);
+}
+
+void operator delete[](void *p) throw()
+{
+	free(p);
+}
+
+//C++14 compilers call these instead when they know the size
+#ifdef __cpp_sized_deallocation
+void operator delete(void *p, size_t) throw()
+{
+	operator delete(p);
+}
+
+void operator delete[](void *p, size_t) throw()
+{
+	operator delete[](p);
+}
+#endif
+
+bool AllocationCounter::Enabled(void)
+{
+	return true;
+}
+
+#else
+
+bool AllocationCounter::Enabled(void)
+{
+	return false;
+}
+
+#endif
+
+unsigned long AllocationCounter::Count(void)
+{
+	return allocations;
+}
@@ -0,0 +1,21 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+/**
+ * Counts calls to the global operator new, so the vision loop can prove it runs without
+ * allocating once it is started.
+ *
+ * The counting operators are only built when COUNT_ALLOCATIONS is defined, since replacing
+ * operator new affects the whole program. Without it Enabled() returns false and the count
+ * stays at 0. The count covers every task, so a frame that reads 0 allocations really made
+ * none, while a larger number may include allocations made by other tasks at the same time.
+ * Memory IMAQ gets from malloc is not counted.
+ */
+class AllocationCounter
+{
+public:
+	static bool Enabled(void);
+	static unsigned long Count(void);
+};
+
+#endif
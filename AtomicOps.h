@@ -0,0 +1,63 @@
+#ifndef ATOMICOPS_H
+#define ATOMICOPS_H
+
+/**
+ * The few lock-free building blocks shared between tasks. The cRIO compiler (gcc 3.4 for
+ * PowerPC) predates the __sync builtins, so the PowerPC barrier is written out by hand there.
+ *
+ * MEMORY_BARRIER() keeps both the compiler and the processor from moving loads and stores
+ * across it.
+ *
+ * AtomicCompareAndSwap() stores replacement at address only if it still holds expected, and
+ * returns true if it did. It is also a full barrier.
+ *
+ * AtomicIncrement() adds one to a counter that more than one task adds to.
+ */
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+#define MEMORY_BARRIER() __sync_synchronize()
+#elif defined(__GNUC__) && (defined(__PPC__) || defined(__powerpc__))
+#define MEMORY_BARRIER() __asm__ __volatile__ ("sync" : : : "memory")
+#elif defined(__GNUC__)
+#define MEMORY_BARRIER() __asm__ __volatile__ ("" : : : "memory")
+#else
+#error "No MEMORY_BARRIER for this compiler"
+#endif
+
+#if defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1))
+static inline bool AtomicCompareAndSwap(volatile unsigned long *address, unsigned long expected,
+		unsigned long replacement)
+{
+	return __sync_bool_compare_and_swap(address, expected, replacement);
+}
+#elif defined(__GNUC__) && (defined(__PPC__) || defined(__powerpc__))
+static inline bool AtomicCompareAndSwap(volatile unsigned long *address, unsigned long expected,
+		unsigned long replacement)
+{
+	unsigned long previous;
+	__asm__ __volatile__ (
+			"sync\n"
+			"1:	lwarx %0,0,%2\n"
+			"	cmpw 0,%0,%3\n"
+			"	bne- 2f\n"
+			"	stwcx. %4,0,%2\n"
+			"	bne- 1b\n"
+			"	isync\n"
+			"2:"
+			: "=&r" (previous), "+m" (*address)
+			: "r" (address), "r" (expected), "r" (replacement)
+			: "cc", "memory");
+	return previous == expected;
+}
+#else
+#error "No AtomicCompareAndSwap for this compiler"
+#endif
+
+static inline void AtomicIncrement(volatile unsigned long *address)
+{
+	unsigned long value;
+	do
+		value = *address;
+	while (!AtomicCompareAndSwap(address, value, value + 1));
+}
+
+#endif
@@ -0,0 +1,131 @@
+#include "BackgroundTask.h"
+#ifdef _WRS_KERNEL
+#include <sysLib.h>
+#else
+#include <errno.h>
+#include <time.h>
+#endif
+
+/**
+ * Background task. See BackgroundTask.h.
+ */
+
+/**
+ * @param name Name of the task, as VxWorks shows it
+ * @param priority VxWorks priority, higher numbers running after lower ones
+ */
+BackgroundTask::BackgroundTask(const char *name, int priority)
+{
+	function = NULL;
+	argument = NULL;
+	started = false;
+#ifdef _WRS_KERNEL
+	task = new Task(name, (FUNCPTR) Run, priority);
+	wake = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+	finished = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+#else
+	(void) name;
+	(void) priority;
+	sem_init(&wake, 0, 0);
+#endif
+}
+
+BackgroundTask::~BackgroundTask()
+{
+	Join();
+#ifdef _WRS_KERNEL
+	delete task;
+	semDelete(wake);
+	semDelete(finished);
+#else
+	sem_destroy(&wake);
+#endif
+}
+
+/**
+ * Starts running in_function(in_argument) on the task.
+ *
+ * @return false if it is already running or the task can't be started
+ */
+bool BackgroundTask::Start(void (*in_function)(void *), void *in_argument)
+{
+	if (started)
+		return false;
+	function = in_function;
+	argument = in_argument;
+#ifdef _WRS_KERNEL
+	started = task->Start((UINT32) this);
+#else
+	started = pthread_create(&thread, NULL, Run, this) == 0;
+#endif
+	return started;
+}
+
+/**
+ * Waits for the function to return, if it was started.
+ */
+void BackgroundTask::Join(void)
+{
+	if (!started)
+		return;
+#ifdef _WRS_KERNEL
+	semTake(finished, WAIT_FOREVER);
+#else
+	pthread_join(thread, NULL);
+#endif
+	started = false;
+}
+
+/**
+ * Wakes the task out of WaitForSignal(), or stops its next one waiting.
+ */
+void BackgroundTask::Signal(void)
+{
+#ifdef _WRS_KERNEL
+	semGive(wake);
+#else
+	sem_post(&wake);
+#endif
+}
+
+/**
+ * Called from the function to wait until Signal() or, if seconds isn't negative, until that
+ * long has passed.
+ */
+void BackgroundTask::WaitForSignal(double seconds)
+{
+#ifdef _WRS_KERNEL
+	semTake(wake, seconds < 0 ? WAIT_FOREVER : (int) (seconds * sysClkRateGet() + 0.5));
+#else
+	if (seconds < 0)
+	{
+		while (sem_wait(&wake) != 0 && errno == EINTR)
+			;
+		return;
+	}
+	struct timespec until;
+	clock_gettime(CLOCK_REALTIME, &until);
+	long nanoseconds = until.tv_nsec + (long) ((seconds - (long) seconds) * 1e9);
+	until.tv_sec += (time_t) seconds + nanoseconds / 1000000000;
+	until.tv_nsec = nanoseconds % 1000000000;
+	while (sem_timedwait(&wake, &until) != 0 && errno == EINTR)
+		;
+#endif
+}
+
+#ifdef _WRS_KERNEL
+int BackgroundTask::Run(UINT32 backgroundTask)
+{
+	BackgroundTask *t = (BackgroundTask *) backgroundTask;
+	t->function(t->argument);
+	semGive(t->finished);
+	return 0;
+}
+#else
+void *BackgroundTask::Run(void *backgroundTask)
+{
+	BackgroundTask *t = (BackgroundTask *) backgroundTask;
+	t->function(t->argument);
+	return NULL;
+}
+#endif
@@ -0,0 +1,56 @@
+#ifndef BACKGROUNDTASK_H
+#define BACKGROUNDTASK_H
+
+#ifdef _WRS_KERNEL
+#include "WPILib.h"
+#include <semLib.h>
+#else
+#include <pthread.h>
+#include <semaphore.h>
+#endif
+
+/**
+ * A task for background work such as writing logs, which runs a function once until it returns
+ * and can be woken up and waited for.
+ *
+ * In the robot build it is a WPILib Task at the priority it is given, like Vision2823's task,
+ * so it is scheduled below the control loops and Notifiers with everything else on the cRIO.
+ * Elsewhere (tools/ and the simulation in sim/) it is a pthread and the priority is ignored.
+ *
+ * The function waits with WaitForSignal(), and another task wakes it early with Signal(), which
+ * never blocks. Join() waits for the function to return.
+ */
+class BackgroundTask
+{
+private:
+	void (*function)(void *);
+	void *argument;
+	volatile bool started;
+#ifdef _WRS_KERNEL
+	Task *task;
+	SEM_ID wake;
+	SEM_ID finished;
+
+	static int Run(UINT32 backgroundTask);
+#else
+	pthread_t thread;
+	sem_t wake;
+
+	static void *Run(void *backgroundTask);
+#endif
+
+	//not copyable
+	BackgroundTask(const BackgroundTask &);
+	BackgroundTask &operator=(const BackgroundTask &);
+
+public:
+	BackgroundTask(const char *name, int priority);
+	~BackgroundTask();
+
+	bool Start(void (*in_function)(void *), void *in_argument);
+	void Join(void);
+	void Signal(void);
+	void WaitForSignal(double seconds);
+};
+
+#endif
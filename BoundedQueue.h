@@ -0,0 +1,110 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include "AtomicOps.h"
+
+/**
+ * Fixed size first in, first out queue that any number of threads can push to and pop from
+ * without a lock. Every cell carries a sequence number that says whether it is waiting for a
+ * push or a pop on the current lap around the ring, so a thread claims a cell with a single
+ * compare and swap on the push or pop position and never waits on another thread.
+ *
+ * The capacity is rounded up to a power of two and all storage is allocated by the
+ * constructor. TryPush() fails when the queue is full and TryPop() when it is empty. TryPop()
+ * can also fail for a moment while another thread is part way through a push into the cell
+ * at the front, so a caller that knows an item is there should just try again.
+ */
+template <class T>
+class BoundedQueue
+{
+private:
+	struct Cell {
+		volatile unsigned long sequence;
+		T value;
+	};
+	Cell *cells;
+	unsigned long mask;
+	char padPush[64];	//keep the two positions on their own cache lines
+	volatile unsigned long pushPosition;
+	char padPop[64];
+	volatile unsigned long popPosition;
+
+	//not copyable
+	BoundedQueue(const BoundedQueue &);
+	BoundedQueue &operator=(const BoundedQueue &);
+
+public:
+	BoundedQueue(int capacity)
+	{
+		unsigned long size = 2;
+		while (size < (unsigned long) capacity)
+			size <<= 1;
+		cells = new Cell[size];
+		for (unsigned long i = 0; i < size; i++)
+			cells[i].sequence = i;
+		mask = size - 1;
+		pushPosition = 0;
+		popPosition = 0;
+	}
+
+	~BoundedQueue()
+	{
+		delete [] cells;
+	}
+
+	bool TryPush(const T &value)
+	{
+		Cell *cell;
+		unsigned long position = pushPosition;
+		for (;;)
+		{
+			cell = &cells[position & mask];
+			unsigned long sequence = cell->sequence;
+			MEMORY_BARRIER();
+			long difference = (long) (sequence - position);
+			if (difference == 0)
+			{
+				if (AtomicCompareAndSwap(&pushPosition, position, position + 1))
+					break;
+			}
+			else if (difference < 0)
+			{
+				return false;	//the cell still holds an item from the last lap, so the queue is full
+			}
+			position = pushPosition;
+		}
+		cell->value = value;
+		MEMORY_BARRIER();
+		cell->sequence = position + 1;
+		return true;
+	}
+
+	bool TryPop(T *value)
+	{
+		Cell *cell;
+		unsigned long position = popPosition;
+		for (;;)
+		{
+			cell = &cells[position & mask];
+			unsigned long sequence = cell->sequence;
+			MEMORY_BARRIER();
+			long difference = (long) (sequence - (position + 1));
+			if (difference == 0)
+			{
+				if (AtomicCompareAndSwap(&popPosition, position, position + 1))
+					break;
+			}
+			else if (difference < 0)
+			{
+				return false;	//nothing has been pushed into the cell yet
+			}
+			position = popPosition;
+		}
+		*value = cell->value;
+		MEMORY_BARRIER();
+		cell->sequence = position + mask + 1;
+		return true;
+	}
+};
+
+#endif
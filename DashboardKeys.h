@@ -0,0 +1,38 @@
+#ifndef DASHBOARDKEYS_H
+#define DASHBOARDKEYS_H
+
+/**
+ * The values the robot shows on the dashboard through DashboardPublisher, with the names
+ * tools/DashboardReceiver prints for them (the SmartDashboard names they used to be put under)
+ * and how often each may be sent. Add new keys at the end so older receivers still decode.
+ */
+enum DashboardKey {
+	DASHBOARD_SPEED,				//shooter speed estimate, counts/s
+	DASHBOARD_HIGH_GOAL,			//1 while the high goal is in view, otherwise 0
+	DASHBOARD_HIGH_DISTANCE,		//feet to the high goal, from its width
+	DASHBOARD_HIGH_X,				//high goal center and size in pixels
+	DASHBOARD_HIGH_Y,
+	DASHBOARD_HIGH_WIDTH,
+	DASHBOARD_HIGH_HEIGHT,
+	DASHBOARD_AIM_Y,				//row the high goal should be at for a shot
+	DASHBOARD_KEY_COUNT
+};
+
+struct DashboardKeyInfo {
+	const char *name;
+	double minInterval;				//seconds between sends of this key, however often it changes
+	double deadband;				//changes no bigger than this wait for the next refresh
+};
+
+static const DashboardKeyInfo dashboardKeys[DASHBOARD_KEY_COUNT] = {
+	{ "speed", 0.05, 1 },
+	{ "HighGoalNumber", 0, 0 },
+	{ "highD", 0.1, 0.05 },
+	{ "highX", 0, 0 },
+	{ "highY", 0, 0 },
+	{ "highWidth", 0, 0 },
+	{ "highHeight", 0, 0 },
+	{ "PerfectY", 0, 0 },
+};
+
+#endif
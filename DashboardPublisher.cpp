@@ -0,0 +1,193 @@
+#include "DashboardPublisher.h"
+#include <string.h>
+#include <math.h>
+#ifdef _WRS_KERNEL
+#include <sockLib.h>
+#include <inetLib.h>
+#include <ioLib.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Batched dashboard values over UDP. See DashboardPublisher.h.
+ */
+
+/**
+ * @param in_clock Clock used to stamp datagrams and time the intervals, in seconds
+ * @param capacity Datagrams that can wait to be sent
+ */
+DashboardPublisher::DashboardPublisher(double (*in_clock)(void), int capacity) :
+	queue(capacity),
+	task("dashboard", DASHBOARD_SEND_PRIORITY)
+{
+	clock = in_clock;
+	sock = -1;
+	running = false;
+	for (int i = 0; i < DASHBOARD_KEY_COUNT; i++)
+	{
+		values[i] = 0;
+		valueSet[i] = false;
+		sentValues[i] = 0;
+		sentTimes[i] = 0;
+		everSent[i] = false;
+	}
+	sequence = 0;
+	sent = 0;
+	dropped = 0;
+	sendFailures = 0;
+	bytesSent = 0;
+}
+
+DashboardPublisher::~DashboardPublisher()
+{
+	Stop();
+}
+
+/**
+ * Starts sending to a dashboard, for example tools/DashboardReceiver on the driver station.
+ *
+ * @param address Dotted IP address to send to
+ */
+bool DashboardPublisher::Start(const char *address, int port)
+{
+	if (running)
+		return false;
+	struct sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_port = htons(port);
+	to.sin_addr.s_addr = inet_addr((char *) address);
+	sock = socket(AF_INET, SOCK_DGRAM, 0);
+	if (sock < 0)
+		return false;
+	//connecting a UDP socket only sets where send() goes
+	if (connect(sock, (struct sockaddr *) &to, sizeof(to)) != 0)
+	{
+		close(sock);
+		sock = -1;
+		return false;
+	}
+	running = true;
+	if (!task.Start(RunTask, this))
+	{
+		running = false;
+		close(sock);
+		sock = -1;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Sends whatever is still waiting and closes the socket.
+ */
+void DashboardPublisher::Stop(void)
+{
+	if (!running)
+		return;
+	running = false;
+	task.Signal();
+	task.Join();
+}
+
+/**
+ * Called once at the end of each control loop tick. Puts the values worth sending into one
+ * datagram for the sending task, and forgets every value set this tick.
+ */
+void DashboardPublisher::Flush(void)
+{
+	if (!running)
+	{
+		for (int i = 0; i < DASHBOARD_KEY_COUNT; i++)
+			valueSet[i] = false;
+		return;
+	}
+	DashboardDatagram datagram;
+	double now = clock();
+	unsigned char *p = datagram.data + DASHBOARD_HEADER_SIZE;
+	unsigned short count = 0;
+
+	for (int i = 0; i < DASHBOARD_KEY_COUNT; i++)
+	{
+		if (!valueSet[i])
+			continue;
+		valueSet[i] = false;
+		const DashboardKeyInfo *info = &dashboardKeys[i];
+		double since = now - sentTimes[i];
+		bool changed = !everSent[i] || fabs(values[i] - sentValues[i]) > info->deadband;
+		if (!(changed && since >= info->minInterval) && since < DASHBOARD_REFRESH_PERIOD)
+			continue;
+		unsigned char key = i;
+		float value = values[i];
+		*p++ = key;
+		memcpy(p, &value, sizeof(value));
+		p += sizeof(value);
+		count++;
+		sentValues[i] = values[i];
+		sentTimes[i] = now;
+		everSent[i] = true;
+	}
+	if (count == 0)
+		return;
+
+	unsigned int magic = DASHBOARD_MAGIC;
+	unsigned int number = ++sequence;
+	unsigned short version = DASHBOARD_VERSION;
+	unsigned int unused = 0;
+	memcpy(datagram.data, &magic, 4);
+	memcpy(datagram.data + 4, &number, 4);
+	memcpy(datagram.data + 8, &version, 2);
+	memcpy(datagram.data + 10, &count, 2);
+	memcpy(datagram.data + 12, &unused, 4);
+	memcpy(datagram.data + 16, &now, 8);
+	datagram.size = p - datagram.data;
+
+	if (!queue.TryPush(datagram))
+	{
+		dropped++;
+		return;
+	}
+	task.Signal();
+}
+
+void DashboardPublisher::RunTask(void *publisher)
+{
+	((DashboardPublisher *) publisher)->Run();
+}
+
+void DashboardPublisher::Run(void)
+{
+	while (running)
+	{
+		task.WaitForSignal(-1);
+		Drain();
+	}
+	Drain();
+	close(sock);
+	sock = -1;
+}
+
+/**
+ * Sends everything in the queue. A datagram the network won't take is counted as dropped
+ * rather than retried, since a newer one will be along next tick.
+ */
+void DashboardPublisher::Drain(void)
+{
+	DashboardDatagram datagram;
+	while (queue.TryPop(&datagram))
+	{
+		if (send(sock, (char *) datagram.data, datagram.size, 0) == datagram.size)
+		{
+			sent++;
+			bytesSent += datagram.size;
+		}
+		else
+		{
+			sendFailures++;
+		}
+	}
+}
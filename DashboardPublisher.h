@@ -0,0 +1,103 @@
+#ifndef DASHBOARDPUBLISHER_H
+#define DASHBOARDPUBLISHER_H
+
+#include "BoundedQueue.h"
+#include "DashboardKeys.h"
+#include "BackgroundTask.h"
+
+//Datagrams that can wait for the sending task before Flush() starts dropping them
+#define DASHBOARD_CAPACITY 16
+//Seconds after which a key is sent again even if it hasn't changed, so a dashboard started
+//late, or one that lost a datagram, catches up
+#define DASHBOARD_REFRESH_PERIOD 1.0
+//VxWorks priority of the sending task, well below the control loops, the Notifiers and vision
+#define DASHBOARD_SEND_PRIORITY 200
+
+//First word of a datagram, in the robot's byte order so a receiver can tell which that was
+#define DASHBOARD_MAGIC 0x44534842
+#define DASHBOARD_VERSION 1
+//Bytes of the datagram header and of each value after it
+#define DASHBOARD_HEADER_SIZE 24
+#define DASHBOARD_VALUE_SIZE 5
+#define DASHBOARD_MAX_DATAGRAM (DASHBOARD_HEADER_SIZE + DASHBOARD_KEY_COUNT * DASHBOARD_VALUE_SIZE)
+
+/**
+ * One datagram, built by Flush() and waiting to be sent.
+ */
+struct DashboardDatagram {
+	int size;
+	unsigned char data[DASHBOARD_MAX_DATAGRAM];
+};
+
+/**
+ * Sends the dashboard values (DashboardKeys.h) as one UDP datagram per control loop tick
+ * holding only the values that changed, instead of a NetworkTables update for every value.
+ *
+ * The control loop calls Set() for each value as it works it out, which only stores it, and
+ * Flush() once at the end of the tick. Only keys Set() since the last Flush() can be sent, so a
+ * value the robot has stopped setting, such as where the goal was after it was lost, is never
+ * sent again. Of those, Flush() picks out the ones worth sending: those that have moved by more
+ * than their deadband since they were last sent, as long as their minimum interval has passed,
+ * and any that haven't been sent for DASHBOARD_REFRESH_PERIOD. A change held back by the
+ * interval goes out the next time the key is Set() once the interval is up. The
+ * datagram is pushed onto a lock-free BoundedQueue for a low priority BackgroundTask to send, so
+ * neither call ever blocks or allocates; if the queue is full the datagram is dropped and
+ * counted.
+ *
+ * A datagram is a 24 byte header, then 5 bytes for each value: the key as one byte and the
+ * value as a float. The header holds, in order, DASHBOARD_MAGIC and a sequence number as 32 bit
+ * words, DASHBOARD_VERSION and the number of values as 16 bit words, 4 unused bytes and the
+ * time of the Flush() as a double. Everything is in the robot's byte order.
+ * tools/DashboardReceiver decodes them.
+ *
+ * Set() and Flush() must be called from one task. This file does not use WPILib, so the clock
+ * is passed in: Timer::GetFPGATimestamp on the robot.
+ */
+class DashboardPublisher
+{
+private:
+	double (*clock)(void);
+	BoundedQueue<DashboardDatagram> queue;
+	BackgroundTask task;
+	int sock;
+	volatile bool running;
+
+	double values[DASHBOARD_KEY_COUNT];
+	bool valueSet[DASHBOARD_KEY_COUNT];
+	double sentValues[DASHBOARD_KEY_COUNT];
+	double sentTimes[DASHBOARD_KEY_COUNT];
+	bool everSent[DASHBOARD_KEY_COUNT];
+	unsigned int sequence;
+
+	volatile unsigned long dropped;		//datagrams Flush() couldn't queue, counted by Flush() only
+	volatile unsigned long sendFailures;	//datagrams the network wouldn't take, counted by the sending task only
+	volatile unsigned long sent, bytesSent;
+
+	static void RunTask(void *publisher);
+	void Run(void);
+	void Drain(void);
+
+public:
+	DashboardPublisher(double (*in_clock)(void), int capacity = DASHBOARD_CAPACITY);
+	~DashboardPublisher();
+
+	bool Start(const char *address, int port);
+	void Stop(void);
+	void Flush(void);
+
+	/**
+	 * Stores a value to be sent by the next Flush(), if it is worth sending. A value that
+	 * should be refreshed while it holds steady has to be set every tick.
+	 */
+	void Set(int key, double value)
+	{
+		values[key] = value;
+		valueSet[key] = true;
+	}
+
+	unsigned long GetSentCount(void) const { return sent; }
+	unsigned long GetDroppedCount(void) const { return dropped + sendFailures; }
+	unsigned long GetBytesSent(void) const { return bytesSent; }
+};
+
+#endif
@@ -0,0 +1,76 @@
+#include "FlywheelControlLoop.h"
+
+/**
+ * Flywheel control task. See FlywheelControlLoop.h.
+ */
+
+/**
+ * @param in_encoder The flywheel's encoder
+ * @param in_speed Estimator the encoder is sampled into
+ * @param in_controller Controller, with its setpoint and gains already set
+ * @param in_motor Motor the controller drives
+ * @param in_period Seconds between updates
+ */
+FlywheelControlLoop::FlywheelControlLoop(Encoder *in_encoder, FlywheelSpeed *in_speed,
+		FlywheelController *in_controller, PIDJaguar *in_motor, double in_period)
+{
+	encoder = in_encoder;
+	speed = in_speed;
+	controller = in_controller;
+	motor = in_motor;
+	period = in_period;
+	lastTime = 0;
+	enabled = false;
+	semaphore = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE);
+	notifier = new Notifier(CallUpdate, this);
+}
+
+FlywheelControlLoop::~FlywheelControlLoop()
+{
+	notifier->Stop();
+	delete notifier;
+	semDelete(semaphore);
+}
+
+/**
+ * Starts sampling the encoder. The motor is left alone until Enable().
+ */
+void FlywheelControlLoop::Start(void)
+{
+	lastTime = Timer::GetFPGATimestamp();
+	notifier->StartPeriodic(period);
+}
+
+void FlywheelControlLoop::Enable(void)
+{
+	Synchronized sync(semaphore);
+	if (!enabled)
+		controller->Reset();
+	enabled = true;
+}
+
+/**
+ * Stops driving the motor and sets it to 0.
+ */
+void FlywheelControlLoop::Disable(void)
+{
+	Synchronized sync(semaphore);
+	enabled = false;
+	motor->Set(0.0);
+}
+
+void FlywheelControlLoop::CallUpdate(void *loop)
+{
+	((FlywheelControlLoop *) loop)->Update();
+}
+
+void FlywheelControlLoop::Update(void)
+{
+	Synchronized sync(semaphore);
+	double now = Timer::GetFPGATimestamp();
+	speed->Update(encoder->Get(), now);
+	double dt = now - lastTime;
+	lastTime = now;
+	if (enabled)
+		motor->Set(controller->Calculate(speed->GetSpeed(), dt));
+}
@@ -0,0 +1,47 @@
+#ifndef FLYWHEELCONTROLLOOP_H
+#define FLYWHEELCONTROLLOOP_H
+
+#include "WPILib.h"
+#include "FlywheelSpeed.h"
+#include "FlywheelController.h"
+#include "PIDJaguar.h"
+
+/**
+ * Runs a FlywheelController on a Notifier at a fixed period, the way a PIDController runs.
+ *
+ * Every period the encoder is sampled into the FlywheelSpeed, whether the loop is enabled or
+ * not, so the speed estimate is always current for the rest of the robot to read. While the
+ * loop is enabled the estimate is then run through the controller and the result written to
+ * the motor. This task is the only one that updates the FlywheelSpeed.
+ *
+ * The motor is a PIDJaguar, whose Set() keeps the command so PIDJaguar::Feed() in the control
+ * loop repeats the controller's latest command rather than an old one.
+ */
+class FlywheelControlLoop
+{
+private:
+	Encoder *encoder;
+	FlywheelSpeed *speed;
+	FlywheelController *controller;
+	PIDJaguar *motor;
+	Notifier *notifier;
+	SEM_ID semaphore;
+	double period;
+	double lastTime;
+	volatile bool enabled;
+
+	static void CallUpdate(void *loop);
+	void Update(void);
+
+public:
+	FlywheelControlLoop(Encoder *in_encoder, FlywheelSpeed *in_speed, FlywheelController *in_controller,
+			PIDJaguar *in_motor, double in_period);
+	~FlywheelControlLoop();
+
+	void Start(void);
+	void Enable(void);
+	void Disable(void);
+	bool IsEnabled(void) const { return enabled; }
+};
+
+#endif
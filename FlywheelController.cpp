@@ -0,0 +1,125 @@
+#include "FlywheelController.h"
+
+/**
+ * Flywheel velocity control. See FlywheelController.h.
+ */
+
+/**
+ * @param in_kP Effort per unit of speed error
+ * @param in_kI Effort per unit of speed error per second
+ * @param in_kD Effort per unit of speed change per second
+ * @param in_kV Feedforward effort per unit of setpoint, about 1 / the speed at full effort
+ * @param in_kS Feedforward effort to overcome friction whenever the setpoint isn't 0
+ */
+FlywheelController::FlywheelController(double in_kP, double in_kI, double in_kD, double in_kV, double in_kS)
+{
+	SetPID(in_kP, in_kI, in_kD);
+	SetFeedforward(in_kV, in_kS);
+	minOutput = 0;
+	maxOutput = 1;
+	inverted = false;
+	bangBang = false;
+	bangBangBand = 0;
+	setpoint = 0;
+	Reset();
+}
+
+void FlywheelController::SetPID(double in_kP, double in_kI, double in_kD)
+{
+	kP = in_kP;
+	kI = in_kI;
+	kD = in_kD;
+}
+
+void FlywheelController::SetFeedforward(double in_kV, double in_kS)
+{
+	kV = in_kV;
+	kS = in_kS;
+}
+
+/**
+ * Sets the range of effort the motor can be given, 0 to 1 for a flywheel that should only ever
+ * be driven forwards.
+ */
+void FlywheelController::SetOutputRange(double minimum, double maximum)
+{
+	minOutput = minimum;
+	maxOutput = maximum;
+}
+
+void FlywheelController::SetInverted(bool in_inverted)
+{
+	inverted = in_inverted;
+}
+
+/**
+ * @param enabled Give full effort while the speed is more than band below the setpoint
+ * @param band Speed below the setpoint where the PID takes over
+ */
+void FlywheelController::SetBangBang(bool enabled, double band)
+{
+	bangBang = enabled;
+	bangBangBand = band;
+}
+
+void FlywheelController::SetSetpoint(double in_setpoint)
+{
+	setpoint = in_setpoint;
+}
+
+/**
+ * Clears the integral and the derivative history, for when the controller is enabled again.
+ */
+void FlywheelController::Reset(void)
+{
+	integral = 0;
+	lastSpeed = 0;
+	haveLastSpeed = false;
+	error = 0;
+	output = 0;
+}
+
+/**
+ * Works out the motor command for one step.
+ *
+ * @param speed Measured flywheel speed, in the same units as the setpoint
+ * @param dt Seconds since the last step
+ * @return Motor command
+ */
+double FlywheelController::Calculate(double speed, double dt)
+{
+	error = setpoint - speed;
+	double derivative = haveLastSpeed && dt > 0 ? (speed - lastSpeed) / dt : 0;
+	lastSpeed = speed;
+	haveLastSpeed = true;
+
+	double effort;
+	if (setpoint == 0)
+	{
+		effort = 0;		//let it coast down rather than hold 0 against the friction
+	}
+	else if (bangBang && error > bangBangBand)
+	{
+		effort = maxOutput;
+	}
+	else
+	{
+		double feedforward = kS + kV * setpoint;
+		effort = feedforward + kP * error + kI * integral - kD * derivative;
+		//only integrate when that doesn't drive the effort further past the clamp
+		bool saturatedHigh = effort >= maxOutput && error > 0;
+		bool saturatedLow = effort <= minOutput && error < 0;
+		if (!saturatedHigh && !saturatedLow)
+		{
+			integral += error * dt;
+			effort = feedforward + kP * error + kI * integral - kD * derivative;
+		}
+	}
+
+	if (effort > maxOutput)
+		effort = maxOutput;
+	if (effort < minOutput)
+		effort = minOutput;
+	output = inverted ? -effort : effort;
+	return output;
+}
@@ -0,0 +1,61 @@
+#ifndef FLYWHEELCONTROLLER_H
+#define FLYWHEELCONTROLLER_H
+
+/**
+ * Velocity controller for a flywheel. The output is a feedforward guess at the motor command
+ * that holds the setpoint (kS to overcome friction plus kV per unit of speed) plus a PID
+ * correction on the speed error:
+ *
+ *   effort = kS + kV * setpoint + kP * error + kI * integral(error) - kD * d(speed)/dt
+ *
+ * The derivative is taken of the speed rather than the error, so a new setpoint doesn't kick.
+ * The effort is clamped to the output range, and the integral only grows while that doesn't push
+ * the effort further into the clamp, so it can't wind up during spin-up or a long stall.
+ *
+ * With bang-bang spin-up turned on, the controller gives full effort whenever the speed is more
+ * than a band below the setpoint, as it is at spin-up and right after a shot, and hands back to
+ * the feedforward and PID inside the band with the integral left where it was.
+ *
+ * SetInverted() is for motors wired so that a negative command spins the flywheel forwards.
+ * The gains and the output range are then still given for positive effort, and Calculate()
+ * negates its result.
+ *
+ * Calculate() is a plain function of the speed and the time step, so the controller can be run
+ * from a Notifier (FlywheelControlLoop), a control loop or a simulation. This file does not use
+ * WPILib.
+ */
+class FlywheelController
+{
+private:
+	double kP, kI, kD, kV, kS;
+	double minOutput, maxOutput;
+	bool inverted;
+	bool bangBang;
+	double bangBangBand;
+
+	double setpoint;
+	double integral;
+	double lastSpeed;
+	bool haveLastSpeed;
+	double error;
+	double output;
+
+public:
+	FlywheelController(double in_kP, double in_kI, double in_kD, double in_kV, double in_kS);
+
+	void SetPID(double in_kP, double in_kI, double in_kD);
+	void SetFeedforward(double in_kV, double in_kS);
+	void SetOutputRange(double minimum, double maximum);
+	void SetInverted(bool in_inverted);
+	void SetBangBang(bool enabled, double band);
+
+	void SetSetpoint(double in_setpoint);
+	double GetSetpoint(void) const { return setpoint; }
+	double GetError(void) const { return error; }
+	double GetOutput(void) const { return output; }
+
+	void Reset(void);
+	double Calculate(double speed, double dt);
+};
+
+#endif
@@ -0,0 +1,90 @@
+#include "FlywheelSim.h"
+
+/**
+ * Shooter plant model. See FlywheelSim.h.
+ */
+
+FlywheelSimParameters FlywheelSim::DefaultParameters(void)
+{
+	FlywheelSimParameters p;
+	p.freeSpeed = 350;
+	p.timeConstant = 0.8;
+	p.friction = 15;
+	p.shotLoss = 0.15;
+	p.shotDuration = 0.04;
+	p.batteryVoltage = 12;
+	p.deadband = 0.05;
+	p.inverted = true;
+	return p;
+}
+
+FlywheelSim::FlywheelSim(const FlywheelSimParameters &in_parameters)
+{
+	parameters = in_parameters;
+	Reset();
+}
+
+/**
+ * Stops the flywheel and sets the clock back to 0.
+ */
+void FlywheelSim::Reset(void)
+{
+	command = 0;
+	speed = 0;
+	position = 0;
+	time = 0;
+	shotEnd = 0;
+}
+
+/**
+ * Sets the motor command the way Jaguar::Set does, -1 to 1.
+ */
+void FlywheelSim::SetCommand(double in_command)
+{
+	if (in_command > 1)
+		in_command = 1;
+	if (in_command < -1)
+		in_command = -1;
+	command = parameters.inverted ? -in_command : in_command;
+}
+
+/**
+ * Starts a disc through the shooter.
+ */
+void FlywheelSim::FireDisc(void)
+{
+	shotEnd = time + parameters.shotDuration;
+}
+
+/**
+ * Moves the simulation on by dt seconds.
+ */
+void FlywheelSim::Step(double dt)
+{
+	double drive = command;
+	if (drive < parameters.deadband && drive > -parameters.deadband)
+		drive = 0;
+	double target = drive * parameters.freeSpeed * parameters.batteryVoltage / 12;
+	double end = time + dt;
+	while (time < end)
+	{
+		double h = end - time < FLYWHEEL_SIM_STEP ? end - time : FLYWHEEL_SIM_STEP;
+		double acceleration = (target - speed) / parameters.timeConstant;
+		if (speed > 0)
+			acceleration -= parameters.friction;
+		else if (speed < 0)
+			acceleration += parameters.friction;
+		if (time < shotEnd)
+		{
+			//the disc takes shotLoss of the speed, evenly over the time it's in contact
+			double contact = h < shotEnd - time ? h : shotEnd - time;
+			speed -= speed * parameters.shotLoss * contact / parameters.shotDuration;
+		}
+		double next = speed + acceleration * h;
+		if (drive == 0 && ((speed > 0 && next < 0) || (speed < 0 && next > 0)))
+			next = 0;		//friction stops it, it doesn't turn it around
+		position += (speed + next) / 2 * h;
+		speed = next;
+		time += h;
+	}
+}
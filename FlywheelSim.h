@@ -0,0 +1,60 @@
+#ifndef FLYWHEELSIM_H
+#define FLYWHEELSIM_H
+
+//Seconds per integration step inside Step()
+#define FLYWHEEL_SIM_STEP 0.0005
+
+/**
+ * What the simulated shooter is like. Speeds are in encoder counts per second, the units the
+ * robot code works in.
+ */
+struct FlywheelSimParameters {
+	double freeSpeed;		//speed the flywheel settles at on a full command at nominal voltage
+	double timeConstant;	//seconds to cover 63% of a step in speed with no friction
+	double friction;		//constant slowdown in counts/s per second while spinning
+	double shotLoss;		//fraction of the speed a disc takes with it
+	double shotDuration;	//seconds the disc is in contact with the wheel
+	double batteryVoltage;	//volts at the Jaguar, the free speed is for 12
+	double deadband;		//commands smaller than this don't move the motor
+	bool inverted;			//a negative command spins the flywheel forwards, as on the robot
+};
+
+/**
+ * Model of the shooter: a Jaguar driving a motor and flywheel, read by a single magnetic pickup.
+ *
+ * The motor and flywheel are a first order system. A command c gives a target speed of
+ * c * freeSpeed * batteryVoltage / 12 and the flywheel closes on it with the time constant, the
+ * way a DC motor with inertia does. Friction slows it by a constant amount. Firing a disc takes
+ * shotLoss of the speed, spread over shotDuration. The encoder count is the whole number of
+ * pulses that have gone past, so speed estimates see the same quantization as on the robot.
+ *
+ * The defaults are a rough fit to the 2013 shooter (about 350 counts/s flat out, a couple of
+ * seconds to spin up, a disc costs about 15% of the speed). This file does not use WPILib.
+ */
+class FlywheelSim
+{
+private:
+	FlywheelSimParameters parameters;
+	double command;
+	double speed;
+	double position;
+	double time;
+	double shotEnd;
+
+public:
+	static FlywheelSimParameters DefaultParameters(void);
+
+	FlywheelSim(const FlywheelSimParameters &in_parameters);
+
+	void Reset(void);
+	void SetCommand(double in_command);
+	void FireDisc(void);
+	void Step(double dt);
+
+	long GetCount(void) const { return (long) position; }
+	double GetSpeed(void) const { return speed; }
+	double GetTime(void) const { return time; }
+	bool IsShooting(void) const { return time < shotEnd; }
+};
+
+#endif
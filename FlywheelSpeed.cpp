@@ -0,0 +1,78 @@
+#include "FlywheelSpeed.h"
+
+/**
+ * Flywheel speed estimate. See FlywheelSpeed.h.
+ */
+
+/**
+ * @param in_window Ticks to average the raw speed over, at most MAX_SPEED_WINDOW
+ * @param in_alpha Filter gain for the speed, 0 to 1
+ * @param in_beta Filter gain for the acceleration, 0 to 1
+ */
+FlywheelSpeed::FlywheelSpeed(int in_window, double in_alpha, double in_beta)
+{
+	if (in_window < 1)
+		in_window = 1;
+	if (in_window > MAX_SPEED_WINDOW)
+		in_window = MAX_SPEED_WINDOW;
+	window = in_window;
+	SetFilter(in_alpha, in_beta);
+	Reset();
+}
+
+void FlywheelSpeed::SetFilter(double in_alpha, double in_beta)
+{
+	alpha = in_alpha;
+	beta = in_beta;
+}
+
+/**
+ * Forgets every sample, for when the encoder is reset or hasn't been sampled for a while.
+ */
+void FlywheelSpeed::Reset(void)
+{
+	samples = 0;
+	newest = 0;
+	lastTime = 0;
+	rawSpeed = 0;
+	speed = 0;
+	acceleration = 0;
+}
+
+/**
+ * Takes this tick's encoder sample and updates the estimates.
+ *
+ * @param count Encoder count, from Encoder::Get
+ * @param time Time the count was read in seconds, from Timer::GetFPGATimestamp
+ */
+void FlywheelSpeed::Update(long count, double time)
+{
+	if (samples > 0 && time <= times[newest])
+		return;		//same tick twice
+	newest = (newest + 1) % (MAX_SPEED_WINDOW + 1);
+	counts[newest] = count;
+	times[newest] = time;
+	if (samples <= window)
+		samples++;
+	if (samples < 2)
+	{
+		lastTime = time;
+		return;
+	}
+
+	int oldest = (newest + MAX_SPEED_WINDOW + 2 - samples) % (MAX_SPEED_WINDOW + 1);
+	double raw = (counts[newest] - counts[oldest]) / (times[newest] - times[oldest]);
+	rawSpeed = raw;
+
+	double dt = time - lastTime;
+	lastTime = time;
+	if (samples == 2)
+	{
+		speed = raw;		//nothing to predict from yet
+		return;
+	}
+	double predicted = speed + acceleration * dt;
+	double residual = raw - predicted;
+	speed = predicted + alpha * residual;
+	acceleration = acceleration + beta * residual / dt;
+}
@@ -0,0 +1,57 @@
+#ifndef FLYWHEELSPEED_H
+#define FLYWHEELSPEED_H
+
+//Most control loop ticks the speed can be averaged over
+#define MAX_SPEED_WINDOW 16
+//Ticks the raw speed is averaged over by default, 0.1 s at 50 Hz
+#define SPEED_WINDOW 5
+//Default alpha-beta filter gains: how far one raw speed moves the speed and the acceleration
+#define SPEED_ALPHA 0.3
+#define SPEED_BETA 0.05
+
+/**
+ * Estimates the shooter flywheel's speed and acceleration from its encoder count, sampled once
+ * per control loop tick, so every user of the speed in that tick sees the same value instead of
+ * each asking the encoder for a new noisy rate.
+ *
+ * The shooter encoder is a single magnetic pickup, so a rate from the time between two edges
+ * jumps around with every edge. Instead the raw speed is the change in count over the last
+ * few ticks divided by the time they took, which is exact apart from the one count either end
+ * can be off by. That goes through an alpha-beta filter, which predicts the speed from the last
+ * acceleration and moves the speed by alpha and the acceleration by beta (over the tick time)
+ * of the difference. An alpha of 1 and a beta of 0 turn the filter off.
+ *
+ * Speeds are in encoder counts per second, the same units as Encoder::GetRate with the default
+ * distance per pulse. Update() is called by one task. The getters can be called from any task;
+ * each value is read whole, though the speed and acceleration may come from different ticks.
+ *
+ * This file does not use WPILib so the estimator can be run on a PC.
+ */
+class FlywheelSpeed
+{
+private:
+	long counts[MAX_SPEED_WINDOW + 1];
+	double times[MAX_SPEED_WINDOW + 1];
+	int window;
+	int samples;		//samples stored so far, up to window + 1
+	int newest;
+	double alpha;
+	double beta;
+	double lastTime;
+	volatile double rawSpeed;
+	volatile double speed;
+	volatile double acceleration;
+
+public:
+	FlywheelSpeed(int in_window = SPEED_WINDOW, double in_alpha = SPEED_ALPHA, double in_beta = SPEED_BETA);
+
+	void SetFilter(double in_alpha, double in_beta);
+	void Reset(void);
+	void Update(long count, double time);
+
+	double GetSpeed(void) const { return speed; }
+	double GetAcceleration(void) const { return acceleration; }
+	double GetRawSpeed(void) const { return rawSpeed; }
+};
+
+#endif
@@ -0,0 +1,274 @@
+#include "HSVThreshold.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HSV_THRESHOLD_SSE2
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define HSV_THRESHOLD_NEON
+#endif
+
+/**
+ * Color threshold used in place of ColorImage::ThresholdHSV. See HSVThreshold.h for the exact
+ * HSV conversion used.
+ */
+
+//Byte offsets of the color planes inside an IMAQ RGBValue
+#define BLUE_OFFSET 0
+#define GREEN_OFFSET 1
+#define RED_OFFSET 2
+#define PIXEL_SIZE 4
+
+HSVThreshold::HSVThreshold(int hue_low, int hue_high, int sat_low, int sat_high, int val_low, int val_high)
+{
+	hueLow = hue_low;
+	hueHigh = hue_high;
+	saturationLow = sat_low;
+	saturationHigh = sat_high;
+	valueLow = val_low;
+	valueHigh = val_high;
+}
+
+/**
+ * Computes the hue of a pixel scaled to 0-255.
+ *
+ * @return The hue (0-255), 0 for gray pixels
+ */
+int HSVThreshold::Hue(int b, int g, int r)
+{
+	int max = r, min = r;
+	int num;
+	if (g > max) max = g;
+	if (b > max) max = b;
+	if (g < min) min = g;
+	if (b < min) min = b;
+	int delta = max - min;
+	if (delta == 0)
+		return 0;
+
+	//num/delta is the position around the color wheel in sixths, 0 to just under 6
+	if (max == r)
+	{
+		num = g - b;
+		if (num < 0)
+			num += 6 * delta;
+	}
+	else if (max == g)
+	{
+		num = 2 * delta + b - r;
+	}
+	else
+	{
+		num = 4 * delta + r - g;
+	}
+	return num * 256 / (6 * delta);
+}
+
+/**
+ * Computes the saturation of a pixel scaled to 0-255.
+ */
+int HSVThreshold::Saturation(int b, int g, int r)
+{
+	int max = r, min = r;
+	if (g > max) max = g;
+	if (b > max) max = b;
+	if (g < min) min = g;
+	if (b < min) min = b;
+	if (max == 0)
+		return 0;
+	return 255 * (max - min) / max;
+}
+
+/**
+ * Computes the value (brightness) of a pixel, 0-255.
+ */
+int HSVThreshold::Value(int b, int g, int r)
+{
+	int max = r;
+	if (g > max) max = g;
+	if (b > max) max = b;
+	return max;
+}
+
+bool HSVThreshold::HueInRange(int b, int g, int r) const
+{
+	int hue = Hue(b, g, r);
+	return hue >= hueLow && hue <= hueHigh;
+}
+
+/**
+ * Tests one pixel against all three ranges. Value and saturation are checked first since they
+ * don't need a division, the hue is only computed when both of them pass.
+ *
+ * @return True if the pixel is inside the threshold
+ */
+bool HSVThreshold::Test(int b, int g, int r) const
+{
+	int max = r, min = r;
+	if (g > max) max = g;
+	if (b > max) max = b;
+	if (g < min) min = g;
+	if (b < min) min = b;
+
+	if (max < valueLow || max > valueHigh)
+		return false;
+
+	//saturation = 255*(max-min)/max truncated, compared without dividing
+	int scaledDelta = 255 * (max - min);
+	if (max == 0)
+	{
+		if (saturationLow > 0)
+			return false;
+	}
+	else if (scaledDelta < saturationLow * max || scaledDelta >= (saturationHigh + 1) * max)
+	{
+		return false;
+	}
+	return HueInRange(b, g, r);
+}
+
+void HSVThreshold::ApplyRowScalar(const unsigned char *pixels, unsigned char *mask, int count) const
+{
+	for (int i = 0; i < count; i++)
+	{
+		const unsigned char *p = pixels + i * PIXEL_SIZE;
+		mask[i] = Test(p[BLUE_OFFSET], p[GREEN_OFFSET], p[RED_OFFSET]) ? 1 : 0;
+	}
+}
+
+#if defined(HSV_THRESHOLD_SSE2)
+/**
+ * Value and saturation test for 4 pixels, one pixel per 32 bit lane of the result.
+ */
+static inline __m128i CandidatesSSE2(__m128i px, __m128i valueLow, __m128i valueHigh,
+		__m128i satLow, __m128i satHigh, __m128i zeroMaxOk)
+{
+	const __m128i lowByte = _mm_set1_epi32(0xFF);
+	const __m128i scale = _mm_set1_epi32(255);
+	//byte 0 of each lane ends up holding max (or min) of blue, green and red
+	__m128i g = _mm_srli_epi32(px, 8);
+	__m128i r = _mm_srli_epi32(px, 16);
+	__m128i max = _mm_and_si128(_mm_max_epu8(_mm_max_epu8(px, g), r), lowByte);
+	__m128i min = _mm_and_si128(_mm_min_epu8(_mm_min_epu8(px, g), r), lowByte);
+
+	__m128i ok = _mm_andnot_si128(_mm_cmplt_epi32(max, valueLow), _mm_cmplt_epi32(max, valueHigh));
+
+	//every product fits in 16 bits, so the 16 bit multiply leaves the exact value in each lane
+	__m128i scaledDelta = _mm_mullo_epi16(_mm_sub_epi32(max, min), scale);
+	__m128i lower = _mm_mullo_epi16(max, satLow);
+	__m128i upper = _mm_mullo_epi16(max, satHigh);
+	__m128i satOk = _mm_andnot_si128(_mm_cmplt_epi32(scaledDelta, lower), _mm_cmplt_epi32(scaledDelta, upper));
+	satOk = _mm_or_si128(satOk, _mm_and_si128(_mm_cmpeq_epi32(max, _mm_setzero_si128()), zeroMaxOk));
+
+	return _mm_and_si128(ok, satOk);
+}
+#endif
+
+/**
+ * Thresholds as much of a row as the vector unit can handle, 16 pixels at a time.
+ *
+ * @return The number of pixels done, the rest of the row is left for ApplyRowScalar
+ */
+int HSVThreshold::ApplyRowVector(const unsigned char *pixels, unsigned char *mask, int count) const
+{
+	int done = 0;
+#if defined(HSV_THRESHOLD_SSE2)
+	const __m128i vLow = _mm_set1_epi32(valueLow);
+	const __m128i vHigh = _mm_set1_epi32(valueHigh + 1);
+	const __m128i sLow = _mm_set1_epi32(saturationLow);
+	const __m128i sHigh = _mm_set1_epi32(saturationHigh + 1);
+	const __m128i zeroMaxOk = _mm_set1_epi32(saturationLow == 0 ? -1 : 0);
+
+	for (; done + 16 <= count; done += 16)
+	{
+		const unsigned char *p = pixels + done * PIXEL_SIZE;
+		__m128i c0 = CandidatesSSE2(_mm_loadu_si128((const __m128i *) (p)), vLow, vHigh, sLow, sHigh, zeroMaxOk);
+		__m128i c1 = CandidatesSSE2(_mm_loadu_si128((const __m128i *) (p + 16)), vLow, vHigh, sLow, sHigh, zeroMaxOk);
+		__m128i c2 = CandidatesSSE2(_mm_loadu_si128((const __m128i *) (p + 32)), vLow, vHigh, sLow, sHigh, zeroMaxOk);
+		__m128i c3 = CandidatesSSE2(_mm_loadu_si128((const __m128i *) (p + 48)), vLow, vHigh, sLow, sHigh, zeroMaxOk);
+		__m128i packed = _mm_packs_epi16(_mm_packs_epi32(c0, c1), _mm_packs_epi32(c2, c3));
+		int bits = _mm_movemask_epi8(packed);
+
+		_mm_storeu_si128((__m128i *) (mask + done), _mm_setzero_si128());
+		while (bits)
+		{
+			int i = __builtin_ctz(bits);
+			bits &= bits - 1;
+			const unsigned char *px = p + i * PIXEL_SIZE;
+			mask[done + i] = HueInRange(px[BLUE_OFFSET], px[GREEN_OFFSET], px[RED_OFFSET]) ? 1 : 0;
+		}
+	}
+#elif defined(HSV_THRESHOLD_NEON)
+	const uint16x8_t vLow = vdupq_n_u16(valueLow);
+	const uint16x8_t vHigh = vdupq_n_u16(valueHigh);
+	const uint16x8_t sLow = vdupq_n_u16(saturationLow);
+	const uint16x8_t sHigh = vdupq_n_u16(saturationHigh + 1);
+	const uint16x8_t scale = vdupq_n_u16(255);
+	const uint16x8_t zero = vdupq_n_u16(0);
+	const uint16x8_t zeroMaxOk = vdupq_n_u16(saturationLow == 0 ? 0xFFFF : 0);
+	unsigned char candidates[16];
+
+	for (; done + 16 <= count; done += 16)
+	{
+		const unsigned char *p = pixels + done * PIXEL_SIZE;
+		uint8x16x4_t px = vld4q_u8(p);
+		uint8x16_t max8 = vmaxq_u8(vmaxq_u8(px.val[BLUE_OFFSET], px.val[GREEN_OFFSET]), px.val[RED_OFFSET]);
+		uint8x16_t min8 = vminq_u8(vminq_u8(px.val[BLUE_OFFSET], px.val[GREEN_OFFSET]), px.val[RED_OFFSET]);
+		uint8x8_t halves[2];
+		for (int h = 0; h < 2; h++)
+		{
+			uint16x8_t max = vmovl_u8(h ? vget_high_u8(max8) : vget_low_u8(max8));
+			uint16x8_t min = vmovl_u8(h ? vget_high_u8(min8) : vget_low_u8(min8));
+			uint16x8_t ok = vandq_u16(vcgeq_u16(max, vLow), vcleq_u16(max, vHigh));
+			uint16x8_t scaledDelta = vmulq_u16(vsubq_u16(max, min), scale);
+			uint16x8_t satOk = vandq_u16(vcgeq_u16(scaledDelta, vmulq_u16(max, sLow)),
+					vcltq_u16(scaledDelta, vmulq_u16(max, sHigh)));
+			satOk = vorrq_u16(satOk, vandq_u16(vceqq_u16(max, zero), zeroMaxOk));
+			halves[h] = vmovn_u16(vandq_u16(ok, satOk));
+		}
+		uint8x16_t cand = vcombine_u8(halves[0], halves[1]);
+		uint64x2_t any = vreinterpretq_u64_u8(cand);
+
+		memset(mask + done, 0, 16);
+		if ((vgetq_lane_u64(any, 0) | vgetq_lane_u64(any, 1)) == 0)
+			continue;
+		vst1q_u8(candidates, cand);
+		for (int i = 0; i < 16; i++)
+		{
+			if (candidates[i])
+			{
+				const unsigned char *c = p + i * PIXEL_SIZE;
+				mask[done + i] = HueInRange(c[BLUE_OFFSET], c[GREEN_OFFSET], c[RED_OFFSET]) ? 1 : 0;
+			}
+		}
+	}
+#else
+	(void) pixels;
+	(void) mask;
+	(void) count;
+#endif
+	return done;
+}
+
+/**
+ * Thresholds an image into a mask of the same size.
+ *
+ * @param pixels First pixel of the image, 4 bytes per pixel (blue, green, red, alpha)
+ * @param pixelStride Bytes from the start of one image row to the next
+ * @param mask First byte of the output mask, one byte per pixel
+ * @param maskStride Bytes from the start of one mask row to the next
+ * @param width Width of the area to threshold in pixels
+ * @param height Height of the area to threshold in pixels
+ */
+void HSVThreshold::Apply(const unsigned char *pixels, int pixelStride, unsigned char *mask, int maskStride,
+		int width, int height) const
+{
+	for (int y = 0; y < height; y++)
+	{
+		const unsigned char *row = pixels + y * pixelStride;
+		unsigned char *out = mask + y * maskStride;
+		int done = ApplyRowVector(row, out, width);
+		ApplyRowScalar(row + done * PIXEL_SIZE, out + done, width - done);
+	}
+}
@@ -0,0 +1,58 @@
+#ifndef HSVTHRESHOLD_H
+#define HSVTHRESHOLD_H
+
+/**
+ * HSV color threshold that works directly on packed 32 bit pixels, so it can be used in place of
+ * ColorImage::ThresholdHSV without building an HSV image first.
+ *
+ * Pixels are laid out the way IMAQ stores RGB images (RGBValue): blue, green, red, alpha. The
+ * mask gets 1 for every pixel inside all three ranges and 0 everywhere else, the same values
+ * ThresholdHSV writes into its BinaryImage.
+ *
+ * Hue, saturation and value are all scaled to 0-255 like the IMAQ threshold ranges:
+ *   V = max(R,G,B)
+ *   S = 255*(max-min)/max				(0 when max is 0)
+ *   H = 256*(hue in degrees)/360		(0 when max equals min)
+ * with every division truncated. Value and saturation only need the max and min of a pixel, so
+ * they are checked first (on 16 pixels at a time where SSE2 or NEON is available) and the hue is
+ * only worked out for the few pixels that survive.
+ *
+ * These formulas are this file's reading of the IMAQ documentation; the mask has not been
+ * compared with what ThresholdHSV produces on the cRIO, so check a few frames against it before
+ * relying on exact edge pixels. The SSE2 path was checked bit for bit against the scalar one.
+ * The NEON path has never been compiled or run, and the cRIO's PowerPC uses neither, so on the
+ * robot every pixel goes through the scalar code.
+ *
+ * This file does not use WPILib so the same kernel can be run on the robot and on a PC.
+ */
+class HSVThreshold
+{
+private:
+	int hueLow, hueHigh;
+	int saturationLow, saturationHigh;
+	int valueLow, valueHigh;
+
+	bool HueInRange(int b, int g, int r) const;
+	void ApplyRowScalar(const unsigned char *pixels, unsigned char *mask, int count) const;
+	int ApplyRowVector(const unsigned char *pixels, unsigned char *mask, int count) const;
+
+public:
+	HSVThreshold(int hue_low, int hue_high, int sat_low, int sat_high, int val_low, int val_high);
+
+	static int Hue(int b, int g, int r);
+	static int Saturation(int b, int g, int r);
+	static int Value(int b, int g, int r);
+
+	bool Test(int b, int g, int r) const;
+	void Apply(const unsigned char *pixels, int pixelStride, unsigned char *mask, int maskStride,
+			int width, int height) const;
+
+	int GetHueLow(void) const { return hueLow; }
+	int GetHueHigh(void) const { return hueHigh; }
+	int GetSaturationLow(void) const { return saturationLow; }
+	int GetSaturationHigh(void) const { return saturationHigh; }
+	int GetValueLow(void) const { return valueLow; }
+	int GetValueHigh(void) const { return valueHigh; }
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include "HurricaneFeed.h"
+
+/**
+ * Hurricane feed task. See HurricaneFeed.h.
+ */
+
+/**
+ * @param in_hurricane Relay that turns the hurricane
+ * @param in_hurricaneSwitch Switch that is closed while a disc is being fed
+ * @param in_period Seconds between samples of the switch
+ */
+HurricaneFeed::HurricaneFeed(Relay *in_hurricane, DigitalInput *in_hurricaneSwitch, double in_period) :
+	edges(HURRICANE_EDGE_QUEUE),
+	shots(HURRICANE_SHOT_QUEUE)
+{
+	hurricane = in_hurricane;
+	hurricaneSwitch = in_hurricaneSwitch;
+	period = in_period;
+	lastClosed = false;
+	semaphore = semMCreate(SEM_Q_PRIORITY | SEM_DELETE_SAFE | SEM_INVERSION_SAFE);
+	notifier = new Notifier(CallSample, this);
+}
+
+HurricaneFeed::~HurricaneFeed()
+{
+	notifier->Stop();
+	delete notifier;
+	semDelete(semaphore);
+}
+
+/**
+ * Starts sampling the switch. The hurricane is left off until Fire().
+ */
+void HurricaneFeed::Start(void)
+{
+	{
+		Synchronized sync(semaphore);
+		lastClosed = hurricaneSwitch->Get() == 1;
+	}
+	notifier->StartPeriodic(period);
+}
+
+/**
+ * Turns the hurricane on for one shot. Does nothing if a shot is already under way.
+ */
+void HurricaneFeed::Fire(void)
+{
+	Synchronized sync(semaphore);
+	if (sequencer.IsFeeding())
+		return;
+	lastClosed = hurricaneSwitch->Get() == 1;
+	sequencer.Fire(lastClosed, Timer::GetFPGATimestamp());
+	Drive();
+}
+
+/**
+ * Takes shots one after another, each as soon as SetReady() says the shooter will be at speed.
+ *
+ * @param shotCount Shots to take, 0 to stop after the one under way
+ */
+void HurricaneFeed::FireWhenReady(int shotCount)
+{
+	Synchronized sync(semaphore);
+	sequencer.Queue(shotCount, lastClosed, Timer::GetFPGATimestamp());
+	Drive();
+}
+
+/**
+ * Called every control loop tick while shots are queued.
+ *
+ * @param ready Whether a disc fed now would reach the shooter at speed
+ * @param shotCount GetShotCount() when ready was worked out. If a shot has finished since,
+ * ready is about the speed before that disc went through and is ignored.
+ */
+void HurricaneFeed::SetReady(bool ready, int shotCount)
+{
+	Synchronized sync(semaphore);
+	if (shotCount != sequencer.GetShotCount())
+		return;
+	sequencer.SetReady(ready, lastClosed, Timer::GetFPGATimestamp());
+	Drive();
+}
+
+/**
+ * Stops the hurricane, abandoning any shot under way and any queued.
+ */
+void HurricaneFeed::Stop(void)
+{
+	Synchronized sync(semaphore);
+	sequencer.Abort();
+	Drive();
+}
+
+bool HurricaneFeed::IsFeeding(void)
+{
+	Synchronized sync(semaphore);
+	return sequencer.IsFeeding();
+}
+
+int HurricaneFeed::GetShotCount(void)
+{
+	Synchronized sync(semaphore);
+	return sequencer.GetShotCount();
+}
+
+/**
+ * Takes the oldest switch edge that hasn't been collected yet.
+ *
+ * @return false if there isn't one
+ */
+bool HurricaneFeed::PopEdge(SwitchEdge *edge)
+{
+	return edges.TryPop(edge);
+}
+
+/**
+ * Takes the oldest finished shot that hasn't been collected yet.
+ *
+ * @return false if there isn't one
+ */
+bool HurricaneFeed::PopShot(ShotTiming *shot)
+{
+	return shots.TryPop(shot);
+}
+
+void HurricaneFeed::CallSample(void *feed)
+{
+	((HurricaneFeed *) feed)->Sample();
+}
+
+void HurricaneFeed::Sample(void)
+{
+	Synchronized sync(semaphore);
+	bool closed = hurricaneSwitch->Get() == 1;
+	if (closed == lastClosed)
+		return;
+	lastClosed = closed;
+	SwitchEdge edge;
+	edge.time = Timer::GetFPGATimestamp();
+	edge.closed = closed;
+	edges.TryPush(edge);
+	bool wasTurning = sequencer.IsTurning();
+	if (sequencer.SwitchChanged(edge.closed, edge.time))
+		shots.TryPush(sequencer.GetLastShot());
+	if (sequencer.IsTurning() != wasTurning)
+		Drive();
+}
+
+//turns the hurricane on or off to match the sequencer, called with the semaphore held
+void HurricaneFeed::Drive(void)
+{
+	hurricane->Set(sequencer.IsTurning() ? Relay::kReverse : Relay::kOff);
+}
@@ -0,0 +1,73 @@
+#ifndef HURRICANEFEED_H
+#define HURRICANEFEED_H
+
+#include "WPILib.h"
+#include "ShotSequencer.h"
+#include "BoundedQueue.h"
+
+//Shots that can finish between two ShotTimings drains before the oldest are dropped
+#define HURRICANE_SHOT_QUEUE 16
+//Switch edges that can wait to be collected before the newest are dropped
+#define HURRICANE_EDGE_QUEUE 32
+
+/**
+ * One change of the hurricane switch, stamped with the time of the sample that saw it.
+ */
+struct SwitchEdge {
+	double time;
+	bool closed;
+};
+
+/**
+ * Runs the hurricane from a ShotSequencer on a fast Notifier, the way FlywheelControlLoop runs
+ * the shooter.
+ *
+ * Every period the hurricane switch is sampled, and when it has changed the edge is handed to
+ * the sequencer stamped with the time of that sample, so it is never more than one period late.
+ * The hurricane is stopped, or sent on to the next queued disc, on the edge that ends a shot,
+ * from the Notifier, instead of waiting for the control loop to look at the switch. A switch
+ * pulse shorter than the period can still be missed, so the period should be well under the
+ * time the switch stays closed.
+ *
+ * Autonomous queues its shots with FireWhenReady() and passes on its ShotReadiness every tick
+ * with SetReady(); the next shot then starts the moment it is ready, or the moment the next disc
+ * comes round if the shooter was ready first, rather than when the control loop next notices
+ * the last shot has finished.
+ *
+ * Each edge and each finished shot's timing go into lock-free queues for the control loop to
+ * collect with PopEdge() and PopShot(), for telemetry. The other methods are called from the
+ * control loop.
+ */
+class HurricaneFeed
+{
+private:
+	Relay *hurricane;
+	DigitalInput *hurricaneSwitch;
+	ShotSequencer sequencer;
+	BoundedQueue<SwitchEdge> edges;
+	BoundedQueue<ShotTiming> shots;
+	Notifier *notifier;
+	SEM_ID semaphore;
+	double period;
+	bool lastClosed;
+
+	static void CallSample(void *feed);
+	void Sample(void);
+	void Drive(void);
+
+public:
+	HurricaneFeed(Relay *in_hurricane, DigitalInput *in_hurricaneSwitch, double in_period);
+	~HurricaneFeed();
+
+	void Start(void);
+	void Fire(void);
+	void FireWhenReady(int shotCount);
+	void SetReady(bool ready, int shotCount);
+	void Stop(void);
+	bool IsFeeding(void);
+	int GetShotCount(void);
+	bool PopEdge(SwitchEdge *edge);
+	bool PopShot(ShotTiming *shot);
+};
+
+#endif
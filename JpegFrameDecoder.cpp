@@ -0,0 +1,154 @@
+#include "JpegFrameDecoder.h"
+
+/**
+ * JPEG decoding straight into a caller's buffer. See JpegFrameDecoder.h.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * there unless VISION_LIBJPEG says libjpeg has been added to the build.
+ */
+#if !defined(_WRS_KERNEL) || defined(VISION_LIBJPEG)
+
+#include <stdio.h>
+#include <setjmp.h>
+#include <jpeglib.h>
+
+struct JpegFrameDecoderState {
+	struct jpeg_decompress_struct cinfo;
+	struct jpeg_error_mgr errors;
+	jmp_buf recover;
+	unsigned char *row;		//one row of 3 byte pixels, for the formats libjpeg can't write 4 bytes of
+};
+
+//libjpeg's own handler exits the program, so jump back out of Decode instead
+static void decodeErrorExit(j_common_ptr cinfo)
+{
+	JpegFrameDecoderState *state = (JpegFrameDecoderState *) cinfo->client_data;
+	longjmp(state->recover, 1);
+}
+
+//keep corrupt data warnings quiet, a damaged camera frame just decodes as well as it can
+static void decodeOutputMessage(j_common_ptr cinfo)
+{
+	(void) cinfo;
+}
+
+/**
+ * @param max_width Widest image the caller's buffers can hold, after scaling
+ * @param max_height Tallest image the caller's buffers can hold, after scaling
+ */
+JpegFrameDecoder::JpegFrameDecoder(int max_width, int max_height)
+{
+	state = new JpegFrameDecoderState;
+	state->row = new unsigned char[max_width * 3];
+	state->cinfo.err = jpeg_std_error(&state->errors);
+	state->errors.error_exit = decodeErrorExit;
+	state->errors.output_message = decodeOutputMessage;
+	jpeg_create_decompress(&state->cinfo);
+	state->cinfo.client_data = state;
+	scale = 1;
+	format = JPEG_PIXELS_BGRA;
+	maxWidth = max_width;
+	maxHeight = max_height;
+}
+
+JpegFrameDecoder::~JpegFrameDecoder()
+{
+	jpeg_destroy_decompress(&state->cinfo);
+	delete [] state->row;
+	delete state;
+}
+
+/**
+ * Sets how many times smaller than the JPEG the decoded image is: 1, 2, 4 or 8.
+ */
+void JpegFrameDecoder::SetScale(int in_scale)
+{
+	if (in_scale >= 8)
+		scale = 8;
+	else if (in_scale >= 4)
+		scale = 4;
+	else if (in_scale >= 2)
+		scale = 2;
+	else
+		scale = 1;
+}
+
+/**
+ * Decodes one JPEG.
+ *
+ * @param jpeg The compressed image
+ * @param size Bytes in the compressed image
+ * @param pixels Where the first pixel goes, 4 bytes per pixel in the decoder's format
+ * @param pixelStride Bytes from the start of one row of pixels to the next
+ * @param width Set to the width of the decoded image
+ * @param height Set to the height of the decoded image
+ * @return False if the data is not a JPEG, or decodes bigger than the decoder was made for
+ */
+bool JpegFrameDecoder::Decode(const unsigned char *jpeg, unsigned long size, unsigned char *pixels, int pixelStride,
+		int *width, int *height)
+{
+	struct jpeg_decompress_struct *cinfo = &state->cinfo;
+	if (setjmp(state->recover))
+	{
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+	jpeg_mem_src(cinfo, (unsigned char *) jpeg, size);
+	if (jpeg_read_header(cinfo, TRUE) != JPEG_HEADER_OK)
+	{
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+	cinfo->scale_num = 1;
+	cinfo->scale_denom = scale;
+	bool expand = true;
+	if (format == JPEG_PIXELS_YCBCR)
+	{
+		cinfo->out_color_space = JCS_YCbCr;
+	}
+	else
+	{
+#ifdef JCS_EXTENSIONS
+		cinfo->out_color_space = JCS_EXT_BGRX;
+		expand = false;
+#else
+		cinfo->out_color_space = JCS_RGB;
+#endif
+	}
+	jpeg_calc_output_dimensions(cinfo);
+	if ((int) cinfo->output_width > maxWidth || (int) cinfo->output_height > maxHeight
+			|| cinfo->output_components != (expand ? 3 : 4))
+	{
+		jpeg_abort_decompress(cinfo);
+		return false;
+	}
+	*width = cinfo->output_width;
+	*height = cinfo->output_height;
+
+	jpeg_start_decompress(cinfo);
+	while (cinfo->output_scanline < cinfo->output_height)
+	{
+		unsigned char *out = pixels + cinfo->output_scanline * pixelStride;
+		if (!expand)
+		{
+			jpeg_read_scanlines(cinfo, &out, 1);
+			continue;
+		}
+		unsigned char *row = state->row;
+		jpeg_read_scanlines(cinfo, &row, 1);
+		//read each pixel into locals first so the compiler doesn't have to reload after every store
+		int first = format == JPEG_PIXELS_YCBCR ? 0 : 2;
+		for (int x = 0; x < *width; x++, out += 4, row += 3)
+		{
+			unsigned char a = row[first], b = row[1], c = row[2 - first];
+			out[0] = a;
+			out[1] = b;
+			out[2] = c;
+			out[3] = 0;
+		}
+	}
+	jpeg_finish_decompress(cinfo);
+	return true;
+}
+
+#endif
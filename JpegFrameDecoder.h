@@ -0,0 +1,45 @@
+#ifndef JPEGFRAMEDECODER_H
+#define JPEGFRAMEDECODER_H
+
+//What JpegFrameDecoder writes for each pixel, always 4 bytes
+enum JpegPixelFormat {
+	JPEG_PIXELS_BGRA,	//blue, green, red, unused: the IMAQ RGBValue layout HSVThreshold reads
+	JPEG_PIXELS_YCBCR	//Y, Cb, Cr, unused: the JPEG's own colors, for YCbCrThreshold
+};
+
+struct JpegFrameDecoderState;
+
+/**
+ * Decodes camera JPEGs straight into a buffer the caller owns, in place of AxisCamera::GetImage()
+ * building a new IMAQ image for every frame.
+ *
+ * The decode can be scaled down by 2, 4 or 8 inside the inverse DCT, which skips most of the work
+ * instead of shrinking a full size image afterwards. With JPEG_PIXELS_YCBCR the pixels are left
+ * in YCbCr, so no color conversion is done at all and the frame goes to a YCbCrThreshold.
+ *
+ * This uses libjpeg (libjpeg-turbo on a PC). The cRIO image doesn't include it, so on the robot
+ * this file is only built when VISION_LIBJPEG is defined. One decoder must not be used by two
+ * threads at once.
+ */
+class JpegFrameDecoder
+{
+private:
+	JpegFrameDecoderState *state;
+	int scale;
+	JpegPixelFormat format;
+	int maxWidth, maxHeight;
+
+public:
+	JpegFrameDecoder(int max_width, int max_height);
+	~JpegFrameDecoder();
+
+	void SetScale(int in_scale);
+	void SetFormat(JpegPixelFormat in_format) { format = in_format; }
+	int GetScale(void) const { return scale; }
+	JpegPixelFormat GetFormat(void) const { return format; }
+
+	bool Decode(const unsigned char *jpeg, unsigned long size, unsigned char *pixels, int pixelStride,
+			int *width, int *height);
+};
+
+#endif
@@ -0,0 +1,484 @@
+#include "MjpegStream.h"
+#include "AtomicOps.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WRS_KERNEL
+#include <sockLib.h>
+#include <inetLib.h>
+#include <hostLib.h>
+#include <ioLib.h>
+#include <selectLib.h>
+#else
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
+/**
+ * MJPEG stream reader. See MjpegStream.h.
+ */
+
+//Set in MjpegStream::shared while the newest frame hasn't been taken by the consumer
+#define FRESH_FRAME 4
+//Most header bytes to look through before deciding the stream is garbage
+#define MAX_HEADER_SIZE 4096
+//Most bytes read at a time while looking for the end of the part headers
+#define HEADER_READ_SIZE 512
+
+/**
+ * Finds a header in a block of HTTP headers, ignoring case.
+ *
+ * @return The first character of the value, or NULL if the header isn't there
+ */
+static const char *findHeader(const char *start, const char *end, const char *name)
+{
+	int length = strlen(name);
+	for (const char *line = start; line + length <= end; line++)
+	{
+		if (line != start && line[-1] != '\n')
+			continue;
+		int i = 0;
+		while (i < length && tolower((unsigned char) line[i]) == name[i])
+			i++;
+		if (i == length)
+		{
+			const char *value = line + length;
+			while (value < end && (*value == ' ' || *value == '\t'))
+				value++;
+			return value;
+		}
+	}
+	return NULL;
+}
+
+//Finds the blank line that ends a block of headers, returns its offset or -1
+static int findHeaderEnd(const unsigned char *data, int size)
+{
+	for (int i = 0; i + 3 < size; i++)
+	{
+		if (data[i] == '\r' && data[i + 1] == '\n' && data[i + 2] == '\r' && data[i + 3] == '\n')
+			return i;
+	}
+	return -1;
+}
+
+/**
+ * Works out the camera's address from a dotted address or, failing that, a host name.
+ *
+ * @return false if it is neither
+ */
+static bool resolveHost(const char *host, struct in_addr *address)
+{
+	address->s_addr = inet_addr((char *) host);
+	if (address->s_addr != INADDR_NONE)
+		return true;
+#ifdef _WRS_KERNEL
+	int found = hostGetByName((char *) host);
+	if (found == ERROR)
+		return false;
+	address->s_addr = found;
+	return true;
+#else
+	struct hostent *entry = gethostbyname(host);
+	if (!entry || entry->h_addrtype != AF_INET)
+		return false;
+	memcpy(address, entry->h_addr_list[0], sizeof(*address));
+	return true;
+#endif
+}
+
+static void toTimeval(double seconds, struct timeval *time)
+{
+	time->tv_sec = (long) seconds;
+	time->tv_usec = (long) ((seconds - time->tv_sec) * 1e6);
+}
+
+/**
+ * Waits for a socket to have something to read or, while connecting, for the connection to be
+ * made or refused.
+ *
+ * @param writable Wait for it to be writable instead of readable, as connect() wants
+ * @return 1 once it is ready, 0 if seconds passed first, -1 if the socket failed
+ */
+static int waitForSocket(int fd, bool writable, double seconds)
+{
+	fd_set set;
+	FD_ZERO(&set);
+	FD_SET(fd, &set);
+	struct timeval timeout;
+	toTimeval(seconds, &timeout);
+	int n = select(fd + 1, writable ? NULL : &set, writable ? &set : NULL, NULL, &timeout);
+#ifndef _WRS_KERNEL
+	if (n < 0 && errno == EINTR)
+		return 0;
+#endif
+	return n > 0 ? 1 : n;
+}
+
+/**
+ * @param in_host Camera address, for example "10.28.23.11"
+ * @param in_port Camera HTTP port, normally 80
+ * @param in_path Path of the MJPEG stream, "/mjpg/video.mjpg" on an Axis camera
+ * @param in_clock Clock used to stamp frames as they arrive, in seconds
+ * @param max_frame_size Largest JPEG to accept, bigger ones are skipped
+ */
+MjpegStream::MjpegStream(const char *in_host, int in_port, const char *in_path, double (*in_clock)(void),
+		int max_frame_size)
+	: task("mjpeg", MJPEG_READ_PRIORITY)
+{
+	strncpy(host, in_host, sizeof(host) - 1);
+	host[sizeof(host) - 1] = 0;
+	port = in_port;
+	strncpy(path, in_path, sizeof(path) - 1);
+	path[sizeof(path) - 1] = 0;
+	clock = in_clock;
+
+	//room for the part headers in front of the JPEG as well
+	bufferSize = max_frame_size + MAX_HEADER_SIZE;
+	for (int i = 0; i < 3; i++)
+	{
+		buffers[i] = new unsigned char[bufferSize];
+		frames[i].data = buffers[i];
+		frames[i].size = 0;
+		frames[i].sequence = 0;
+		frames[i].arrival = 0;
+	}
+	filling = 0;
+	shared = 1;
+	reading = 2;
+#ifdef _WRS_KERNEL
+	frameReady = semBCreate(SEM_Q_PRIORITY, SEM_EMPTY);
+#else
+	sem_init(&frameReady, 0, 0);
+#endif
+	running = false;
+	connected = false;
+	received = 0;
+	dropped = 0;
+	skipped = 0;
+}
+
+MjpegStream::~MjpegStream()
+{
+	Stop();
+#ifdef _WRS_KERNEL
+	semDelete(frameReady);
+#else
+	sem_destroy(&frameReady);
+#endif
+	for (int i = 0; i < 3; i++)
+		delete [] buffers[i];
+}
+
+/**
+ * Starts the task that connects to the camera and reads the stream.
+ *
+ * @return false if the camera's address can't be worked out or the task can't be started
+ */
+bool MjpegStream::Start(void)
+{
+	if (running)
+		return true;
+	struct in_addr address;
+	if (!resolveHost(host, &address))
+		return false;
+	running = true;
+	if (!task.Start(RunTask, this))
+	{
+		running = false;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Closes the stream and stops the task, which takes up to MJPEG_POLL_PERIOD, or
+ * MJPEG_CONNECT_TIMEOUT if it is connecting. A WaitForFrame() in progress returns false.
+ */
+void MjpegStream::Stop(void)
+{
+	if (!running)
+		return;
+	running = false;
+	task.Signal();		//out of the wait between connection attempts
+	task.Join();
+	SignalFrame();
+}
+
+void MjpegStream::RunTask(void *stream)
+{
+	((MjpegStream *) stream)->Run();
+}
+
+/**
+ * Connects, reads until the connection fails, and tries again until stopped.
+ */
+void MjpegStream::Run(void)
+{
+	while (running)
+	{
+		int fd = Connect();
+		if (fd >= 0)
+		{
+			char request[256];
+			int length = sprintf(request, "GET %.128s HTTP/1.0\r\nHost: %.64s\r\n\r\n", path, host);
+			if (running && send(fd, request, length, 0) == length)
+			{
+				connected = true;
+				ReadStream(fd);
+				connected = false;
+			}
+			close(fd);
+		}
+		if (running)
+			task.WaitForSignal(MJPEG_RECONNECT_DELAY);
+	}
+}
+
+/**
+ * Opens a connection to the camera, giving up after MJPEG_CONNECT_TIMEOUT rather than waiting
+ * as long as the network stack would.
+ *
+ * @return The connected socket, or -1
+ */
+int MjpegStream::Connect(void)
+{
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	//looked up again on every attempt in case the name only resolves once the camera is up
+	if (!resolveHost(host, &address.sin_addr))
+		return -1;
+	int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0)
+		return -1;
+#ifdef _WRS_KERNEL
+	struct timeval timeout;
+	toTimeval(MJPEG_CONNECT_TIMEOUT, &timeout);
+	bool made = connectWithTimeout(fd, (struct sockaddr *) &address, sizeof(address), &timeout) == OK;
+#else
+	//what connectWithTimeout() does on VxWorks: start connecting without blocking, then wait
+	int flags = fcntl(fd, F_GETFL, 0);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	bool made = connect(fd, (struct sockaddr *) &address, sizeof(address)) == 0;
+	if (!made && errno == EINPROGRESS && waitForSocket(fd, true, MJPEG_CONNECT_TIMEOUT) > 0)
+	{
+		int error = 0;
+		socklen_t length = sizeof(error);
+		made = getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+	}
+	fcntl(fd, F_SETFL, flags);
+#endif
+	if (!made)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * Reads some bytes from the camera, checking every MJPEG_POLL_PERIOD whether to stop.
+ *
+ * @return The number of bytes read, or -1 if the connection is gone or the stream was stopped
+ */
+int MjpegStream::Receive(int fd, unsigned char *buffer, int size)
+{
+	int ready = 0;
+	while (running && ready == 0)
+		ready = waitForSocket(fd, false, MJPEG_POLL_PERIOD);
+	if (ready <= 0)
+		return -1;
+	int n = recv(fd, (char *) buffer, size, 0);
+	return n > 0 ? n : -1;
+}
+
+//Wakes the consumer out of WaitForFrame()
+void MjpegStream::SignalFrame(void)
+{
+#ifdef _WRS_KERNEL
+	semGive(frameReady);
+#else
+	sem_post(&frameReady);
+#endif
+}
+
+/**
+ * Makes the frame just filled in the newest one, and takes whichever buffer it replaces to fill
+ * next. If the frame it replaces was never taken, that one is dropped.
+ */
+void MjpegStream::Publish(void)
+{
+	unsigned long old;
+	do
+	{
+		old = shared;
+	} while (!AtomicCompareAndSwap(&shared, old, filling | FRESH_FRAME));
+	if (old & FRESH_FRAME)
+		dropped++;
+	filling = old & 3;
+	received++;
+	SignalFrame();
+}
+
+/**
+ * Reads the HTTP response and then one multipart part after another until something goes wrong.
+ * Each part is read straight into the buffer being filled: a small read at a time until the end
+ * of its headers turns up, then exactly the rest of the JPEG, so it never reads past the frame
+ * unless the whole frame came in with the headers.
+ *
+ * @return False when the connection should be dropped and made again
+ */
+bool MjpegStream::ReadStream(int fd)
+{
+	unsigned char *buffer = buffers[filling];
+	unsigned char carry[HEADER_READ_SIZE];
+	char boundary[72];
+	int used = 0, n, end;
+
+	//the HTTP response, which should be a 200 with the multipart boundary in the Content-Type
+	while ((end = findHeaderEnd(buffer, used)) < 0)
+	{
+		if (used >= MAX_HEADER_SIZE || (n = Receive(fd, buffer + used, HEADER_READ_SIZE)) < 0)
+			return false;
+		used += n;
+	}
+	const char *headers = (const char *) buffer;
+	if (used < 12 || strncmp(headers, "HTTP/1.", 7) != 0 || strncmp(headers + 9, "200", 3) != 0)
+		return false;
+	const char *type = findHeader(headers, headers + end, "content-type:");
+	const char *value;
+	boundary[0] = '-';
+	boundary[1] = '-';
+	int boundaryLength = 2;
+	for (value = type; value && value < headers + end && *value != '\r'; value++)
+	{
+		if (strncmp(value, "boundary=", 9) != 0)
+			continue;
+		value += 9;
+		if (*value == '"')
+			value++;
+		if (value[0] == '-' && value[1] == '-')
+			value += 2;		//some servers put the dashes in the header as well
+		while (value < headers + end && *value != '\r' && *value != '"' && *value != ';'
+				&& boundaryLength < (int) sizeof(boundary) - 1)
+			boundary[boundaryLength++] = *value++;
+		break;
+	}
+	if (boundaryLength == 2)
+		return false;
+	boundary[boundaryLength] = 0;
+	used -= end + 4;
+	memmove(buffer, buffer + end + 4, used);
+
+	while (running)
+	{
+		//part headers: the boundary line, then Content-Type and Content-Length
+		while ((end = findHeaderEnd(buffer, used)) < 0)
+		{
+			if (used >= MAX_HEADER_SIZE || (n = Receive(fd, buffer + used, HEADER_READ_SIZE)) < 0)
+				return false;
+			used += n;
+		}
+		headers = (const char *) buffer;
+		const char *start = headers;
+		while (start < headers + end && (*start == '\r' || *start == '\n'))
+			start++;
+		if (strncmp(start, boundary, boundaryLength) != 0)
+			return false;
+		const char *lengthValue = findHeader(start, headers + end, "content-length:");
+		long length = lengthValue ? atol(lengthValue) : 0;
+		if (length <= 0)
+			return false;
+		int bodyStart = end + 4;
+		long extra = used - bodyStart - length;		//bytes of the next part read along with the headers
+
+		if (bodyStart + length > bufferSize)
+		{
+			//too big to keep, read it and throw it away
+			skipped++;
+			if (extra >= 0)
+			{
+				memmove(buffer, buffer + bodyStart + length, extra);
+				used = extra;
+				continue;
+			}
+			for (long remaining = -extra; remaining > 0; remaining -= n)
+			{
+				if ((n = Receive(fd, buffer, remaining < bufferSize ? remaining : bufferSize)) < 0)
+					return false;
+			}
+			used = 0;
+			continue;
+		}
+
+		while (used < bodyStart + length)
+		{
+			if ((n = Receive(fd, buffer + used, bodyStart + length - used)) < 0)
+				return false;
+			used += n;
+		}
+		MjpegFrame *frame = &frames[filling];
+		frame->data = buffer + bodyStart;
+		frame->size = length;
+		frame->sequence = received + skipped + 1;
+		frame->arrival = clock();
+		if (extra > 0)
+			memcpy(carry, buffer + bodyStart + length, extra);
+		Publish();
+		buffer = buffers[filling];
+		used = extra > 0 ? extra : 0;
+		memcpy(buffer, carry, used);
+	}
+	return false;
+}
+
+/**
+ * Takes the newest frame if there is one that hasn't been taken yet. The frame stays valid
+ * until the next call. Only one thread may take frames.
+ *
+ * @return True if frame was filled in with a new frame
+ */
+bool MjpegStream::GetFrame(MjpegFrame *frame)
+{
+	unsigned long old;
+	for (;;)
+	{
+		old = shared;
+		if (!(old & FRESH_FRAME))
+			return false;
+		if (AtomicCompareAndSwap(&shared, old, reading))
+			break;
+	}
+	reading = old & 3;
+	*frame = frames[reading];
+	return true;
+}
+
+/**
+ * Waits for a new frame and takes it, like GetFrame().
+ *
+ * @return False if the stream was stopped
+ */
+bool MjpegStream::WaitForFrame(MjpegFrame *frame)
+{
+	while (running)
+	{
+		if (GetFrame(frame))
+			return true;
+#ifdef _WRS_KERNEL
+		semTake(frameReady, WAIT_FOREVER);
+#else
+		sem_wait(&frameReady);
+#endif
+	}
+	return GetFrame(frame);
+}
@@ -0,0 +1,101 @@
+#ifndef MJPEGSTREAM_H
+#define MJPEGSTREAM_H
+
+#include "BackgroundTask.h"
+#ifdef _WRS_KERNEL
+#include <semLib.h>
+#else
+#include <semaphore.h>
+#endif
+
+//Largest JPEG the stream will hold, bigger frames are skipped
+#define MJPEG_MAX_FRAME_SIZE (256 * 1024)
+//Seconds to wait before reconnecting after the camera drops the stream
+#define MJPEG_RECONNECT_DELAY 0.5
+//Seconds to wait for the camera to accept the connection before trying again
+#define MJPEG_CONNECT_TIMEOUT 2.0
+//Seconds the reader waits for data at a time before checking whether it has been stopped
+#define MJPEG_POLL_PERIOD 0.1
+//VxWorks priority of the reading task, just ahead of the vision task (101) so frames are
+//stamped as they arrive rather than when decoding the last one is finished
+#define MJPEG_READ_PRIORITY 100
+
+/**
+ * One JPEG from the stream. data stays valid until the next GetFrame() or WaitForFrame().
+ */
+struct MjpegFrame {
+	const unsigned char *data;
+	unsigned long size;
+	unsigned long sequence;		//counts every frame received, so a gap means frames were dropped
+	double arrival;				//clock time the last byte of the frame arrived
+};
+
+/**
+ * Keeps an HTTP MJPEG stream open to the camera (or to tools/MjpegServer) and always has the
+ * newest complete frame ready, instead of asking the camera for one frame at a time.
+ *
+ * A BackgroundTask reads the multipart stream. Each part is received straight into one of three
+ * buffers, headers and all, and the JPEG is left where it landed. Once a frame is complete it
+ * is stamped with its arrival time and swapped in as the newest frame. The consumer swaps it
+ * out again when it asks for a frame, so neither side ever waits on the other or copies a frame,
+ * and a frame the consumer didn't get to in time is simply replaced (and counted as dropped).
+ *
+ * Every part needs a Content-Length header, which Axis cameras send. The connection is retried
+ * every MJPEG_RECONNECT_DELAY seconds if it drops, or if the camera doesn't answer within
+ * MJPEG_CONNECT_TIMEOUT. The socket belongs to the reading task alone: it never waits on it for
+ * longer than MJPEG_POLL_PERIOD, so Stop() only has to tell it to finish and wait, within one
+ * period (or the connect timeout, while connecting).
+ *
+ * The clock is passed in: Timer::GetFPGATimestamp on the robot, a monotonic clock on a PC.
+ */
+class MjpegStream
+{
+private:
+	char host[64];
+	int port;
+	char path[128];
+	double (*clock)(void);
+
+	unsigned char *buffers[3];
+	int bufferSize;
+	MjpegFrame frames[3];
+	volatile unsigned long shared;	//index of the newest frame, plus FRESH_FRAME until it is taken
+	int filling;					//only touched by the reading task
+	int reading;					//only touched by the consumer
+
+	BackgroundTask task;
+#ifdef _WRS_KERNEL
+	SEM_ID frameReady;
+#else
+	sem_t frameReady;
+#endif
+	volatile bool running;
+	volatile bool connected;
+	volatile unsigned long received, dropped, skipped;
+
+	static void RunTask(void *stream);
+	void Run(void);
+	int Connect(void);
+	void SignalFrame(void);
+	bool ReadStream(int fd);
+	int Receive(int fd, unsigned char *buffer, int size);
+	void Publish(void);
+
+public:
+	MjpegStream(const char *in_host, int in_port, const char *in_path, double (*in_clock)(void),
+			int max_frame_size = MJPEG_MAX_FRAME_SIZE);
+	~MjpegStream();
+
+	bool Start(void);
+	void Stop(void);
+
+	bool GetFrame(MjpegFrame *frame);
+	bool WaitForFrame(MjpegFrame *frame);
+
+	bool IsConnected(void) const { return connected; }
+	unsigned long GetReceivedCount(void) const { return received; }
+	unsigned long GetDroppedCount(void) const { return dropped; }
+	unsigned long GetSkippedCount(void) const { return skipped; }
+};
+
+#endif
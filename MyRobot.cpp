@@ -6,11 +6,40 @@
 #include "Timer.h"
 //#include "Vision2823.h"
 #include "PIDJaguar.h"
+#include "FlywheelSpeed.h"
+#include "FlywheelController.h"
+#include "FlywheelControlLoop.h"
+#include "HurricaneFeed.h"
+#include "ShotReadiness.h"
+#include "ShooterAngleEstimator.h"
+#include "VisionCalibration.h"
+#include "PeriodicLoop.h"
+#include "TelemetryLog.h"
+#include "TelemetryEvents.h"
+#include "DashboardPublisher.h"
+#include "ShotSettings.h"
 
-#define WHEELSPEED 300
-#define LOWERTHRESHOLD (WHEELSPEED-10)
-#define UPPERTHRESHOLD (WHEELSPEED+10)
-#define MINIMUMSPEED (WHEELSPEED-50)
+#define CONTROLPERIOD 0.02	//seconds between passes of the teleop and autonomous loops
+#ifdef WPILIB_SIMULATION
+#define TELEMETRYFILE "telemetry.bin"	//tools/RobotSim writes it in the directory it is run from
+#define DASHBOARDADDRESS "127.0.0.1"	//tools/RobotSim runs faster than real time, so keep it off the network
+#else
+#define TELEMETRYFILE "/telemetry.bin"	//decode with tools/TelemetryDecode
+#define DASHBOARDADDRESS "10.28.23.5"	//driver station, where tools/DashboardReceiver can stand in for the dashboard
+#endif
+#define DASHBOARDPORT 5801
+#define SHOOTERPERIOD 0.01	//seconds between shooter speed samples and controller updates
+#define SHOOTERSPEEDWINDOW 10	//samples the shooter speed is averaged over, 0.1 s
+//Shooter controller gains, in motor effort per encoder count/s
+#define SHOOTERKP 0.01
+#define SHOOTERKI 0.02
+#define SHOOTERKD 0.0
+#define SHOOTERKV (1.0/350)
+#define SHOOTERKS 0.05
+#define SHOOTERBANGBAND 20	//counts/s under WHEELSPEED where full power hands over to the PID
+#define HURRICANEPERIOD 0.002	//seconds between samples of the hurricane switch
+#define ANGLEPIXELS 220.0	//image rows the target moves over the shooter's full travel (40 rows/s for 5.5 s)
+#define CALIBRATIONFILE "/calibration.txt"	//camera constants and aim rows, see VisionCalibration.h and tools/CalibrationFit
 class RobotDemo : public SimpleRobot
 {
 	RobotDrive DriveWheels;
@@ -21,20 +50,24 @@ class RobotDemo : public SimpleRobot
 	DigitalInput ShooterAngleUp;
 	DigitalInput ShooterAngleDown;
 	Joystick Gamepad;
-	int HurricaneControl;
-	bool Shooting;
-	Timer TimerDown;
-	Timer TimerUp;
+	ShooterAngleEstimator ShooterPosition;	//where ShooterAngle has the shooter, 0 to 1 between the limits
+	VisionCalibration Calibration;	//where the goal should be in the image for a shot, by its width
 	DigitalInput sensor1; //Magnetic Counter
 	Encoder shootEncoder;
+	FlywheelSpeed ShooterSpeed;	//shootEncoder's speed, sampled by ShooterControl every SHOOTERPERIOD
+	FlywheelController ShooterController;
+	FlywheelControlLoop ShooterControl;
+	ShotReadiness ShotReady;	//when to start an autonomous shot so the disc arrives at speed
 	DigitalInput HurricaneSwitch; //Hurricane ON/OFF
-	PIDController ShooterPID;
+	HurricaneFeed Feeder;	//runs Hurricane a shot at a time off HurricaneSwitch edges
 	double StartTime;
 	int StartCount;
 	bool ShooterToggle;
 	bool TargetLock;
 	//Vision2823 vision;
-	double AngleTime;
+	PeriodicLoop ControlLoop;
+	TelemetryLog Telemetry;
+	DashboardPublisher Dashboard;	//dashboard values, one datagram of changes per control loop tick
 	
 public:
 	RobotDemo(void):
@@ -46,75 +79,81 @@ public:
 		ShooterAngleUp(3),
 		ShooterAngleDown(4),
 		Gamepad(1),
-		HurricaneControl(0),
-		Shooting(false),
-		TimerDown(),
-		TimerUp(),
+		ShooterPosition(),
 		sensor1(1),
 		shootEncoder(sensor1, sensor1, false, Encoder::k1X),
+		ShooterSpeed(SHOOTERSPEEDWINDOW),
+		ShooterController(SHOOTERKP, SHOOTERKI, SHOOTERKD, SHOOTERKV, SHOOTERKS),
+		ShooterControl(&shootEncoder, &ShooterSpeed, &ShooterController, &Shooter, SHOOTERPERIOD),
+		ShotReady(WHEELSPEED, UPPERTHRESHOLD-WHEELSPEED, SHOTREACH, SHOTLEADTIME, SHOTCONFIRM),
 		HurricaneSwitch(2),
-		ShooterPID(-0.001, 0.0000, -0.0001, &shootEncoder, &Shooter),
+		Feeder(&Hurricane, &HurricaneSwitch, HURRICANEPERIOD),
 		ShooterToggle(false),
 		TargetLock(false),
 		//vision(0.25),
-		AngleTime(0.0)
+		ControlLoop(CONTROLPERIOD, Timer::GetFPGATimestamp, Wait),
+		Telemetry(Timer::GetFPGATimestamp),
+		Dashboard(Timer::GetFPGATimestamp)
 	{
+		Telemetry.StartFile(TELEMETRYFILE);
+		Dashboard.Start(DASHBOARDADDRESS, DASHBOARDPORT);
+		Calibration.Load(CALIBRATIONFILE);	//keeps the built in calibration if there is no file
+		//vision.SetCalibration(Calibration);
 		//vision.Start();
 		DriveWheels.SetExpiration(0.75);
 		//FrontWheels.SetExpiration(0.75);
 		Shooter.SetExpiration(0.75);
-		Shooter.SetEncoder(&shootEncoder);
-		shootEncoder.SetPIDSourceParameter(Encoder::kRate);
 		shootEncoder.Start();
-		ShooterPID.SetInputRange(0.0, 350.0);
-		ShooterPID.SetSetpoint(WHEELSPEED*1.0);
-		ShooterPID.SetAbsoluteTolerance(5.0);
+		ShooterController.SetOutputRange(0.0, 0.99);
+		ShooterController.SetInverted(true);	//the shooter spins forwards on negative commands
+		ShooterController.SetSetpoint(WHEELSPEED*1.0);
+		ShooterController.SetBangBang(true, SHOOTERBANGBAND);
+		ShooterControl.Start();
+		Feeder.Start();
 	}
 	
 	~RobotDemo() //Failsafe for stupid FRC people
 	{
 		//vision.Stop();
-	}
-
-	void AutoShoot(double howlong)
-	{
-		StartShooting();
-		while (!UpdateShooting() && IsAutonomous() && IsEnabled()) //Only called by autonomous now
-		{
-			Wait(0.05);
-		}
-		StopShooting();
+		Dashboard.Stop();
+		Telemetry.Stop();
 	}
 
 	void Autonomous(void)
 	{
-		int PIDGoodCount = 0;
-		int ShotsTaken = 0;
 		DriveWheels.SetSafetyEnabled(false);
 		//FrontWheels.SetSafetyEnabled(false);
 		Shooter.SetSafetyEnabled(false);
-		ShooterPID.Enable();
-		while (IsAutonomous() && IsEnabled() && ShotsTaken < 8)
+		ShooterControl.Enable();
+		ShotReady.SetLeadTime(SHOTLEADTIME);	//the first disc starts from where the hurricane stopped
+		int FirstShot = Feeder.GetShotCount();
+		int LastShotCount = FirstShot;
+		bool WasReady = false;
+		Feeder.FireWhenReady(8);
+		ControlLoop.Start();
+		while (IsAutonomous() && IsEnabled() && Feeder.GetShotCount() - FirstShot < 8)
 		{
-			if (shootEncoder.GetRate() >= LOWERTHRESHOLD && shootEncoder.GetRate() <= UPPERTHRESHOLD)
+			int ShotCount = Feeder.GetShotCount();
+			if (ShotCount != LastShotCount)
 			{
-				PIDGoodCount ++;
-				printf ("%d\n",PIDGoodCount);
-			}	
-			else if (shootEncoder.GetRate() < MINIMUMSPEED)
-			{
-				PIDGoodCount=0;
-			}
-			if (PIDGoodCount>=5)
-			{
-				AutoShoot(2.0);
-				PIDGoodCount=0;
-				ShotsTaken ++;
+				//Feeder has already turned on to the next disc, so it is only a short way from the shooter
+				ShotReady.SetLeadTime(SHOTSTAGEDLEADTIME);
+				LastShotCount = ShotCount;
 			}
-			Wait (0.05);
+			double speed = ShooterSpeed.GetSpeed();
+			bool Ready = ShotReady.Update(speed, ShooterSpeed.GetAcceleration());
+			if (Ready && !WasReady)
+				Telemetry.Log(TELEMETRY_SHOT_READY, speed, ShotReady.GetPredictedSpeed());
+			WasReady = Ready;
+			Feeder.SetReady(Ready, ShotCount);	//Feeder starts the shot itself, as soon as the disc can go
+			LogShots();
+			ControlLoop.WaitForNextPeriod();
 		}
-		ShooterPID.Disable();
+		StopShooting();
+		LogShots();
+		ShooterControl.Disable();
 		Shooter.Set(0.0);
+		ControlLoop.PrintStatistics("autonomous");
 	}
 
 	void OperatorControl(void)
@@ -127,18 +166,19 @@ public:
 		int PIDGoodCount=0;
 		double lastspeed=-1;
 		//bool DoAutoAim = true;
+		//unsigned long lastVisionSequence = 0;
 		
 		bool lastHurricaneSwitch=!HurricaneSwitch.Get();
 		bool lastShooterUp=!ShooterAngleUp.Get();
 		bool lastShooterDown=!ShooterAngleDown.Get();
-		
-		//NetworkTable *distanceTable = NetworkTable::GetTable("SmartDashboard");
 
 		bool button5DownPriorLoop = false;
 		bool button5Down = false;
 		StopShooting();
+		ControlLoop.Start();
 		while (IsOperatorControl() && IsEnabled())
 		{
+			double speed = ShooterSpeed.GetSpeed();
 			DriveWheels.TankDrive(Gamepad.GetRawAxis(4), Gamepad.GetRawAxis(2));
 			//FrontWheels.TankDrive(-Gamepad.GetRawAxis(2), -Gamepad.GetRawAxis(5));
 			Shooter.Feed();
@@ -157,15 +197,14 @@ public:
 				//printf("Limit of the ShooterAngleUp Switch: %d\n", ShooterAngleUp.Get());
 				lastShooterUp = ShooterAngleUp.Get();
 			}
+			ShooterPosition.Update(ShooterAngleUp.Get()==0, ShooterAngleDown.Get()==0, Timer::GetFPGATimestamp());
 			if (Gamepad.GetRawButton(4))
 			{
-				TimerDown.Start();
-				AngleTime=5.61;
+				ShooterPosition.MoveTo(0.0);
 			}
 			if (Gamepad.GetRawButton(3))
 			{
-				TimerUp.Start();
-				AngleTime=5.5;
+				ShooterPosition.MoveTo(1.0);
 			}
 #ifdef twobutton
 			if (Gamepad.GetRawButton(2)==1)
@@ -177,31 +216,24 @@ public:
 				Hurricane.Set(Relay::kOff);
 			}
 #endif
-			if (Gamepad.GetRawAxis(6) == -1 || (TimerDown.Get() > 0 && TimerDown.HasPeriodPassed(AngleTime) == false))
+			if (Gamepad.GetRawAxis(6) == -1)
 			{
-				AngleMove(-1);
+				ShooterPosition.Drive(-1);
 			}
-			else if (Gamepad.GetRawAxis(6) == 1 || (TimerUp.Get() > 0 && TimerUp.HasPeriodPassed(AngleTime) == false)) 
+			else if (Gamepad.GetRawAxis(6) == 1)
 			{
-				AngleMove(1);
+				ShooterPosition.Drive(1);
 			}
-			else
+			else if (!ShooterPosition.IsMoving())
 			{
-				AngleMove(0);
-				TimerUp.Stop();
-				TimerDown.Stop();
-				TimerUp.Reset();
-				TimerDown.Reset();
+				ShooterPosition.Stop();
 			}
-			if (Gamepad.GetRawAxis(6)==1 || Gamepad.GetRawAxis(6)==-1)
-			{
-				AngleTime=0.0;
-			}	
-			if (shootEncoder.GetRate() >= LOWERTHRESHOLD && shootEncoder.GetRate() <= UPPERTHRESHOLD)
+			AngleMove(ShooterPosition.GetDirection());
+			if (speed >= LOWERTHRESHOLD && speed <= UPPERTHRESHOLD)
 			{
 				PIDGoodCount ++;
 			}	
-			else if (shootEncoder.GetRate() < MINIMUMSPEED)
+			else if (speed < MINIMUMSPEED)
 			{
 				PIDGoodCount=0;
 			}
@@ -233,17 +265,17 @@ public:
 			}
 			button5DownPriorLoop = button5Down;
 			
-			if (shootEncoder.GetRate() != lastspeed)
+			Dashboard.Set(DASHBOARD_SPEED, speed);	//every pass, so it is refreshed while it holds steady
+			if (speed != lastspeed)
 			{    
-				//distanceTable->PutNumber("speed",shootEncoder.GetRate());
-				lastspeed = shootEncoder.GetRate();
-				printf ("%g\n", lastspeed);
+				lastspeed = speed;
+				Telemetry.Log(TELEMETRY_SHOOTER_SPEED, speed, ShooterSpeed.GetAcceleration(), ShooterSpeed.GetRawSpeed());
 			}
 			if (ShooterToggle)
 			{
 				if (! PIDStarted)
 				{
-					ShooterPID.Enable();
+					ShooterControl.Enable();
 				}
 				PIDStarted = true;
 			}
@@ -251,50 +283,53 @@ public:
 			{
 				if (PIDStarted)
 				{
-					ShooterPID.Disable();
+					ShooterControl.Disable();
 					Shooter.Set(0.0);
 				}
 				PIDStarted = false;
 			}
 
 #ifdef visionon
-			if (Gamepad.GetRawButton(1)&& vision.isHighGoal && DoAutoAim)
+			VisionResult visionResult;
+			vision.GetResult(&visionResult);	//one consistent frame for this whole loop
+			if (Gamepad.GetRawButton(1)&& visionResult.isHighGoal && DoAutoAim)
 			{
-					AutoAim(vision.highY, PerfectY(vision.highWidth));
+					AutoAim(visionResult.highY, Calibration.GetAimY(visionResult.highWidth, visionResult.imageWidth),
+							visionResult.timestamp);
 					DoAutoAim=false;
 			}
 
 #endif
 			
-			UpdateShooting();
+			LogShots();
 			//printf ("%d\n",PIDGoodCount);
 
 #ifdef visionon
-			if (vision.Updated())
+			if (visionResult.sequence != lastVisionSequence)
 			{
-				if (vision.isHighGoal)
-					distanceTable->PutNumber("HighGoalNumber",1);
-				else
-					distanceTable->PutNumber("HighGoalNumber",0);
-
-				if (vision.isHighGoal)
+				Dashboard.Set(DASHBOARD_HIGH_GOAL, visionResult.isHighGoal ? 1 : 0);
+				if (visionResult.isHighGoal)
 				{
-					distanceTable->PutNumber("highD", vision.highDistance2);
-					distanceTable->PutNumber("highX", vision.highX);
-					distanceTable->PutNumber("highY", vision.highY);
-					distanceTable->PutNumber("highWidth", vision.highWidth);
-					distanceTable->PutNumber("highHeight", vision.highHeight);
-					distanceTable->PutNumber("PerfectY", PerfectY(vision.highWidth));
+					Dashboard.Set(DASHBOARD_HIGH_DISTANCE, visionResult.highDistance2);
+					Dashboard.Set(DASHBOARD_HIGH_X, visionResult.highX);
+					Dashboard.Set(DASHBOARD_HIGH_Y, visionResult.highY);
+					Dashboard.Set(DASHBOARD_HIGH_WIDTH, visionResult.highWidth);
+					Dashboard.Set(DASHBOARD_HIGH_HEIGHT, visionResult.highHeight);
+					Dashboard.Set(DASHBOARD_AIM_Y, Calibration.GetAimY(visionResult.highWidth, visionResult.imageWidth));
 				}
-				vision.Clear();
+				lastVisionSequence = visionResult.sequence;
 				DoAutoAim=true;
 			}
 #endif
-		//	Wait(0.01);
+			Dashboard.Flush();	//everything that changed this pass goes in one datagram
+			ControlLoop.WaitForNextPeriod();
 		}
-		ShooterPID.Disable();
-		Hurricane.Set(Relay::kOff);
+		ShooterControl.Disable();
+		StopShooting();
+		ShooterPosition.Stop();
+		AngleMove(0);
 		Shooter.Set(0.0);
+		ControlLoop.PrintStatistics("teleop");
 	}
 	int AngleMove(int Direction)
 	{
@@ -313,100 +348,54 @@ public:
 		return (Direction);
 	}
 	
-	int PerfectY(int w)
+	/**
+	 * Moves the shooter so the goal, seen at row CurrentY in a frame captured at captureTime,
+	 * comes to row Py. The shooter may have moved since the frame was taken, so the goal's row
+	 * is first projected to now from how far the shooter has moved since.
+	 */
+	void AutoAim(int CurrentY, double Py, double captureTime)
 	{
-		/*
-		X	Y	Height	Width	Distance
-		147	209	25	77	26.802
-		145	190	34	106	19.470
-		165	173	39	125	16.643
-		171	154	46	155	13.315
-		161	142	51	189	10.919
-		 */
-
-		double ww = 1.0 * w;
-		double ret;
-
-		ret = (.00004593677 * ww) * (ww * ww);
-
-		ret -= .01593994 * (ww * ww);
-
-		ret += 1.05940095 * ww;
-
-		ret += 201.138;
-
-		return (int) ret;
-
-	}
-
-	void AutoAim(int CurrentY, int Py)
-	{
-		double ANGLESPEED = 40.0;
-		double ytime = (Py-CurrentY) / ANGLESPEED;
-		if ((Py<=CurrentY+2) && (Py>=CurrentY-2))
+		double now = Timer::GetFPGATimestamp();
+		double moved = ShooterPosition.GetPosition() - ShooterPosition.GetPositionAt(captureTime);
+		double projectedY = CurrentY + moved * ANGLEPIXELS;
+		if ((Py<=projectedY+2) && (Py>=projectedY-2))
 		{
 			return ;	
 		}
-		if (ytime > 0)
-		{
-			TimerUp.Start();
-			TimerDown.Stop();
-			TimerDown.Reset();
-			AngleTime=ytime;
-		}
-		if (ytime < 0)
-		{
-			TimerDown.Start();
-			AngleTime=-1*ytime;
-			TimerUp.Stop();
-			TimerUp.Reset();
-		}
+		double target = ShooterPosition.GetPosition() + (Py-projectedY) / ANGLEPIXELS;
+		ShooterPosition.MoveTo(target);
+		Telemetry.Log(TELEMETRY_AUTO_AIM, now - captureTime, projectedY, target);
 	}
 	
 	void StartShooting()
 	{
-		if (Shooting == false)
-		{
-			HurricaneControl = 1;
-		}
-		Shooting = true;
+		if (!Feeder.IsFeeding())
+			Telemetry.Log(TELEMETRY_HURRICANE_ON);
+		Feeder.Fire();
 	}
 	
-	bool UpdateShooting()
+	void StopShooting()
 	{
-		bool ShotComplete = false;
-		if (HurricaneControl == 1)
-		{
-			Hurricane.Set(Relay::kReverse);
-			printf ("Hurricane On\n");
-		}
-		if (HurricaneSwitch.Get() == 0 && HurricaneControl == 1)
-		{
-			HurricaneControl = 2;
-		}
-		if (HurricaneSwitch.Get() == 1 && HurricaneControl == 1)
-		{
-			HurricaneControl = 3;
-		}
-		if (HurricaneControl == 2 && HurricaneSwitch.Get() == 1)
-		{
-			HurricaneControl = 3;
-		}
-		if (HurricaneControl == 3 && HurricaneSwitch.Get() == 0)
-		{
-			StopShooting();
-			ShotComplete = true;
-			printf("shot complete\n");
-		}
-		return ShotComplete;
+		Feeder.Stop();
+		Telemetry.Log(TELEMETRY_HURRICANE_OFF);
 	}
-	
-	void StopShooting()
+
+	/**
+	 * Logs the hurricane switch edges and the feed timing of any shots Feeder has finished
+	 * since the last call.
+	 */
+	void LogShots()
 	{
-		HurricaneControl = 0;
-		Shooting = false;
-		Hurricane.Set(Relay::kOff);
-		printf ("Hurricane Off\n");
+		double now = Timer::GetFPGATimestamp();
+		SwitchEdge edge;
+		while (Feeder.PopEdge(&edge))
+			Telemetry.Log(TELEMETRY_HURRICANE_SWITCH, edge.closed ? 1 : 0, now - edge.time);
+		ShotTiming shot;
+		while (Feeder.PopShot(&shot))
+		{
+			double toSwitch = shot.closed > 0 ? shot.closed - shot.start : 0;
+			Telemetry.Log(TELEMETRY_SHOT_COMPLETE, shot.end - shot.start, toSwitch);
+		}
 	}
 };
 
@@ -1,13 +1,12 @@
+#ifndef PIDJAGUAR_H
+#define PIDJAGUAR_H
+
 /*----------------------------------------------------------------------------
-  **    The WPILib PIDController class is accustomed to be used for
-  **    driving to a fixed position, not to a set rate.
-  **    The PIDController.cpp Calculate() logic clearly intends
-  **    for PIDWrite() to be called with a *delta* value; the goal
-  **    is to eventually just call that with 0.  That makes sense
-  **    when you're driving to a position.
-  **    But the Jaguar class expects to be called with an absolute
-  **    value.  So this code just wraps the Jaguar class and provides
-  **    a PIDWrite() function that takes a delta.
+  **    A Jaguar that clamps what it is set to between a minimum and a
+  **    maximum and remembers it.  FlywheelControlLoop sets it to the
+  **    FlywheelController's output every period, and Feed() in the
+  **    control loop repeats that latest output for the motor safety
+  **    timer rather than an old one.
 */
 class PIDJaguar : public Jaguar
 {
@@ -15,7 +14,6 @@ class PIDJaguar : public Jaguar
         float m_speed;
         float m_min_speed;
         float m_max_speed;
-        Encoder *m_enc;
 
     public:
         PIDJaguar(UINT32 channel, float min_speed = -0.99, float max_speed = 0.0) : Jaguar(channel)
@@ -25,11 +23,6 @@ class PIDJaguar : public Jaguar
             m_max_speed = max_speed;
         }
 
-
-        void SetEncoder(Encoder *e)
-        {
-            m_enc = e;
-        }
         void Set(float speed)
         {
             if (speed < m_min_speed)
@@ -40,14 +33,10 @@ class PIDJaguar : public Jaguar
             Jaguar::Set(speed);
         }
 
-        void PIDWrite(float delta)
-        {
-            //printf("%g:  PIDWrite delta %f, to %f, rate %f\n", Timer::GetFPGATimestamp(), delta, m_speed + delta, m_enc->GetRate());
-            Set(m_speed + delta);
-        }
-
         void Feed(void)
         {
             Set(m_speed);
         }
 };
+
+#endif
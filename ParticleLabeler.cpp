@@ -0,0 +1,399 @@
+#include "ParticleLabeler.h"
+#include <math.h>
+#include <limits.h>
+
+/**
+ * Run-length connected component labeling used in place of the ConvexHull, ParticleFilter and
+ * GetOrderedParticleAnalysisReports chain.
+ */
+
+ParticleLabeler::ParticleLabeler(int max_width, int max_height, int max_runs, int max_particles)
+{
+	maxWidth = max_width;
+	maxHeight = max_height;
+	maxRuns = max_runs;
+	maxParticles = max_particles;
+	runCount = 0;
+	particleCount = 0;
+	overflowed = false;
+
+	runY = new int[maxRuns];
+	runStart = new int[maxRuns];
+	runEnd = new int[maxRuns];
+	runParent = new int[maxRuns];
+	runNext = new int[maxRuns];
+	statArea = new int[maxRuns];
+	statLeft = new int[maxRuns];
+	statRight = new int[maxRuns];
+	statTop = new int[maxRuns];
+	statBottom = new int[maxRuns];
+
+	rowLeft = new int[maxHeight];
+	rowRight = new int[maxHeight];
+	//two corner points per row boundary, and room for the hull to wrap back to its first point
+	pointY = new int[2 * (maxHeight + 1)];
+	pointX = new int[2 * (maxHeight + 1)];
+	hullY = new int[4 * (maxHeight + 1)];
+	hullX = new int[4 * (maxHeight + 1)];
+
+	particles = new ParticleReport[maxParticles];
+	columnCounts = new unsigned short[maxParticles * maxWidth];
+	rowCounts = new unsigned short[maxParticles * maxHeight];
+}
+
+ParticleLabeler::~ParticleLabeler()
+{
+	delete [] runY;
+	delete [] runStart;
+	delete [] runEnd;
+	delete [] runParent;
+	delete [] runNext;
+	delete [] statArea;
+	delete [] statLeft;
+	delete [] statRight;
+	delete [] statTop;
+	delete [] statBottom;
+	delete [] rowLeft;
+	delete [] rowRight;
+	delete [] pointY;
+	delete [] pointX;
+	delete [] hullY;
+	delete [] hullX;
+	delete [] particles;
+	delete [] columnCounts;
+	delete [] rowCounts;
+}
+
+int ParticleLabeler::Find(int run)
+{
+	while (runParent[run] != run)
+	{
+		runParent[run] = runParent[runParent[run]];
+		run = runParent[run];
+	}
+	return run;
+}
+
+/**
+ * Merges the particles two runs belong to. The lower run index becomes the root so particles
+ * keep the raster order of their first run.
+ */
+void ParticleLabeler::Union(int a, int b)
+{
+	a = Find(a);
+	b = Find(b);
+	if (a == b)
+		return;
+	if (b < a)
+	{
+		int t = a;
+		a = b;
+		b = t;
+	}
+	runParent[b] = a;
+	statArea[a] += statArea[b];
+	if (statLeft[b] < statLeft[a]) statLeft[a] = statLeft[b];
+	if (statRight[b] > statRight[a]) statRight[a] = statRight[b];
+	if (statTop[b] < statTop[a]) statTop[a] = statTop[b];
+	if (statBottom[b] > statBottom[a]) statBottom[a] = statBottom[b];
+}
+
+/**
+ * Measures the convex hull of one particle. The hull is built around the pixel corners, so a
+ * solid w by h rectangle has an area of exactly w*h and a perimeter of exactly 2*(w+h).
+ *
+ * @param root The root run of the particle
+ * @param report The report to fill in
+ * @param profile Which of the row and column count buffers to fill in
+ */
+void ParticleLabeler::MeasureHull(int root, ParticleReport *report, int profile)
+{
+	int top = statTop[root];
+	int left = statLeft[root];
+	int height = statBottom[root] - top + 1;
+	int width = statRight[root] - left + 1;
+	int i, n, k, lowerSize;
+	unsigned short *columns = columnCounts + profile * maxWidth;
+	unsigned short *rows = rowCounts + profile * maxHeight;
+
+	for (i = 0; i < height; i++)
+	{
+		rowLeft[i] = INT_MAX;
+		rowRight[i] = -1;
+		rows[i] = 0;
+	}
+	//columns starts out holding the change in count from one column to the next
+	for (i = 0; i < width; i++)
+		columns[i] = 0;
+	for (int run = root; run >= 0; run = runNext[run])
+	{
+		int row = runY[run] - top;
+		if (runStart[run] < rowLeft[row]) rowLeft[row] = runStart[run];
+		if (runEnd[run] > rowRight[row]) rowRight[row] = runEnd[run];
+		rows[row] += runEnd[run] - runStart[run] + 1;
+		columns[runStart[run] - left]++;
+		if (runEnd[run] + 1 - left < width)
+			columns[runEnd[run] + 1 - left]--;
+	}
+	for (i = 1; i < width; i++)
+		columns[i] += columns[i - 1];
+	report->columnCounts = columns;
+	report->rowCounts = rows;
+
+	//only the outermost corner on each side of a row boundary can be on the hull,
+	//so the points come out already sorted by y and then x
+	n = 0;
+	for (i = 0; i <= height; i++)
+	{
+		int left = INT_MAX, right = -1;
+		if (i > 0)
+		{
+			left = rowLeft[i - 1];
+			right = rowRight[i - 1];
+		}
+		if (i < height)
+		{
+			if (rowLeft[i] < left) left = rowLeft[i];
+			if (rowRight[i] > right) right = rowRight[i];
+		}
+		pointY[n] = top + i;
+		pointX[n++] = left;
+		pointY[n] = top + i;
+		pointX[n++] = right + 1;
+	}
+
+	//Andrew's monotone chain
+	k = 0;
+	for (i = 0; i < n; i++)
+	{
+		while (k >= 2 && (hullY[k-1] - hullY[k-2]) * (pointX[i] - hullX[k-2])
+				- (hullX[k-1] - hullX[k-2]) * (pointY[i] - hullY[k-2]) <= 0)
+			k--;
+		hullY[k] = pointY[i];
+		hullX[k++] = pointX[i];
+	}
+	lowerSize = k + 1;
+	for (i = n - 2; i >= 0; i--)
+	{
+		while (k >= lowerSize && (hullY[k-1] - hullY[k-2]) * (pointX[i] - hullX[k-2])
+				- (hullX[k-1] - hullX[k-2]) * (pointY[i] - hullY[k-2]) <= 0)
+			k--;
+		hullY[k] = pointY[i];
+		hullX[k++] = pointX[i];
+	}
+	//the last point is the first point again, which closes the polygon
+
+	double area = 0, sumX = 0, sumY = 0, perimeter = 0;
+	for (i = 0; i < k - 1; i++)
+	{
+		double cross = (double) hullX[i] * hullY[i+1] - (double) hullX[i+1] * hullY[i];
+		double dx = hullX[i+1] - hullX[i];
+		double dy = hullY[i+1] - hullY[i];
+		area += cross;
+		sumX += (hullX[i] + hullX[i+1]) * cross;
+		sumY += (hullY[i] + hullY[i+1]) * cross;
+		perimeter += sqrt(dx * dx + dy * dy);
+	}
+	//pixel centers are half a pixel in from the corners the hull was built on
+	double centerX = sumX / (3 * area) - 0.5;
+	double centerY = sumY / (3 * area) - 0.5;
+	area = fabs(area) / 2;
+
+	report->particleArea = area;
+	report->perimeter = perimeter;
+	report->center_mass_x = (int) centerX;
+	report->center_mass_y = (int) centerY;
+	report->center_mass_x_normalized = 2 * centerX / report->imageWidth - 1;
+	report->center_mass_y_normalized = 2 * centerY / report->imageHeight - 1;
+
+	//sides x and y of the rectangle with x*y = area and 2x+2y = perimeter
+	double halfPerimeter = perimeter / 2;
+	double discriminant = halfPerimeter * halfPerimeter - 4 * area;
+	if (discriminant < 0)
+		discriminant = 0;
+	report->equivalentRectLong = (halfPerimeter + sqrt(discriminant)) / 2;
+	report->equivalentRectShort = (halfPerimeter - sqrt(discriminant)) / 2;
+}
+
+/**
+ * Labels a threshold mask and measures every particle at least areaMinimum pixels in size.
+ * The particles are ordered largest first like GetOrderedParticleAnalysisReports.
+ *
+ * @param mask First byte of the mask, non zero for set pixels
+ * @param maskStride Bytes from the start of one mask row to the next
+ * @param width Width of the mask in pixels
+ * @param height Height of the mask in pixels
+ * @param areaMinimum Smallest convex hull area to keep, the same as the old particle filter
+ * @return The number of particles found
+ */
+int ParticleLabeler::Label(const unsigned char *mask, int maskStride, int width, int height, double areaMinimum)
+{
+	ParticleRect area;
+	area.top = 0;
+	area.left = 0;
+	area.height = height;
+	area.width = width;
+	return Label(mask, maskStride, width, height, area, areaMinimum);
+}
+
+/**
+ * Labels only part of a threshold mask.
+ *
+ * @param mask First byte of the whole mask, non zero for set pixels
+ * @param maskStride Bytes from the start of one mask row to the next
+ * @param width Width of the whole mask in pixels
+ * @param height Height of the whole mask in pixels
+ * @param area The part of the mask to label, clipped to the mask
+ * @param areaMinimum Smallest convex hull area to keep, the same as the old particle filter
+ * @return The number of particles found
+ */
+int ParticleLabeler::Label(const unsigned char *mask, int maskStride, int width, int height, const ParticleRect &area,
+		double areaMinimum)
+{
+	return Label(mask, maskStride, width, height, &area, 1, areaMinimum);
+}
+
+/**
+ * Labels several parts of a threshold mask together, so a particle that crosses from one into
+ * another is still one particle.
+ *
+ * @param mask First byte of the whole mask, non zero for set pixels
+ * @param maskStride Bytes from the start of one mask row to the next
+ * @param width Width of the whole mask in pixels
+ * @param height Height of the whole mask in pixels
+ * @param areas The parts of the mask to label, sorted by left edge and not overlapping
+ * @param areaCount Number of areas
+ * @param areaMinimum Smallest convex hull area to keep, the same as the old particle filter
+ * @return The number of particles found
+ */
+int ParticleLabeler::Label(const unsigned char *mask, int maskStride, int width, int height, const ParticleRect *areas,
+		int areaCount, double areaMinimum)
+{
+	int prevFirst = 0, prevLast = 0;
+	int i, a;
+
+	runCount = 0;
+	particleCount = 0;
+	overflowed = false;
+	if (width > maxWidth || height > maxHeight)
+	{
+		overflowed = true;
+		if (width > maxWidth) width = maxWidth;
+		if (height > maxHeight) height = maxHeight;
+	}
+	int top = height, bottom = 0;
+	for (a = 0; a < areaCount; a++)
+	{
+		if (areas[a].top < top) top = areas[a].top;
+		if (areas[a].top + areas[a].height > bottom) bottom = areas[a].top + areas[a].height;
+	}
+	if (top < 0) top = 0;
+	if (bottom > height) bottom = height;
+
+	for (int y = top; y < bottom; y++)
+	{
+		const unsigned char *row = mask + y * maskStride;
+		int curFirst = runCount;
+		int prev = prevFirst;
+
+		for (a = 0; a < areaCount; a++)
+		{
+			const ParticleRect *area = &areas[a];
+			if (y < area->top || y >= area->top + area->height)
+				continue;
+			int x = area->left < 0 ? 0 : area->left;
+			int right = area->left + area->width < width ? area->left + area->width : width;
+
+			while (x < right)
+			{
+				if (!row[x])
+				{
+					x++;
+					continue;
+				}
+				int start = x;
+				while (x < right && row[x])
+					x++;
+				int end = x - 1;
+
+				if (runCount == maxRuns)
+				{
+					overflowed = true;
+					continue;
+				}
+				int run = runCount++;
+				runY[run] = y;
+				runStart[run] = start;
+				runEnd[run] = end;
+				runParent[run] = run;
+				runNext[run] = -1;
+				statArea[run] = end - start + 1;
+				statLeft[run] = start;
+				statRight[run] = end;
+				statTop[run] = y;
+				statBottom[run] = y;
+
+				//join every run in the row above that shares a column with this one
+				while (prev < prevLast && runEnd[prev] < start)
+					prev++;
+				for (int above = prev; above < prevLast && runStart[above] <= end; above++)
+					Union(above, run);
+			}
+		}
+		prevFirst = curFirst;
+		prevLast = runCount;
+	}
+
+	//chain the runs of each particle together behind its root
+	for (i = runCount - 1; i >= 0; i--)
+	{
+		int root = Find(i);
+		if (root != i)
+		{
+			runNext[i] = runNext[root];
+			runNext[root] = i;
+		}
+	}
+
+	for (i = 0; i < runCount; i++)
+	{
+		if (runParent[i] != i)
+			continue;
+		int boxWidth = statRight[i] - statLeft[i] + 1;
+		int boxHeight = statBottom[i] - statTop[i] + 1;
+		//the hull can't be bigger than the bounding box
+		if ((double) boxWidth * boxHeight < areaMinimum)
+			continue;
+		if (particleCount == maxParticles)
+		{
+			overflowed = true;
+			break;
+		}
+
+		ParticleReport *report = &particles[particleCount];
+		report->imageWidth = width;
+		report->imageHeight = height;
+		report->particleRawArea = statArea[i];
+		report->boundingRect.top = statTop[i];
+		report->boundingRect.left = statLeft[i];
+		report->boundingRect.height = boxHeight;
+		report->boundingRect.width = boxWidth;
+		MeasureHull(i, report, particleCount);
+		if (report->particleArea < areaMinimum)
+			continue;
+
+		//insert in order, largest area first
+		int slot = particleCount++;
+		ParticleReport measured = *report;
+		while (slot > 0 && particles[slot - 1].particleArea < measured.particleArea)
+		{
+			particles[slot] = particles[slot - 1];
+			slot--;
+		}
+		particles[slot] = measured;
+	}
+	for (i = 0; i < particleCount; i++)
+		particles[i].particleIndex = i;
+
+	return particleCount;
+}
@@ -0,0 +1,91 @@
+#ifndef PARTICLELABELER_H
+#define PARTICLELABELER_H
+
+//Same layout as the IMAQ Rect so the scoring code can use either one
+struct ParticleRect {
+	int top;
+	int left;
+	int height;
+	int width;
+};
+
+/**
+ * Measurements for one particle, named after the ParticleAnalysisReport fields the scoring code
+ * used to read. All of the shape measurements are taken on the convex hull of the particle, the
+ * same thing the old ConvexHull + ParticleFilter + GetOrderedParticleAnalysisReports chain measured.
+ */
+struct ParticleReport {
+	int imageWidth;
+	int imageHeight;
+	int particleIndex;
+	int center_mass_x;
+	int center_mass_y;
+	double center_mass_x_normalized;	//-1 at the left edge of the image, 1 at the right
+	double center_mass_y_normalized;	//-1 at the top edge of the image, 1 at the bottom
+	double particleArea;				//area of the convex hull in pixels
+	double particleRawArea;				//pixels set in the threshold mask
+	double perimeter;					//perimeter of the convex hull in pixels
+	double equivalentRectLong;			//sides of the rectangle with the same area and perimeter
+	double equivalentRectShort;
+	ParticleRect boundingRect;
+	unsigned short *columnCounts;		//set pixels of this particle in each column of the bounding rect
+	unsigned short *rowCounts;			//and in each row, before the hull fills it in
+};
+
+/**
+ * Finds the particles in a threshold mask in a single pass. Each row is turned into runs of set
+ * pixels, and runs that touch a run in the row above (4-connected, like ConvexHull(false)) are
+ * merged with union-find. The area and bounding box of every particle are kept up to date while
+ * the rows stream past, so particles that can't reach the minimum area are dropped without ever
+ * being measured. The surviving particles get their convex hull worked out from the runs, which
+ * gives the hull area, center of mass and perimeter. The same walk over the runs also counts the
+ * particle's own pixels in every row and column of its bounding rect, which is all the edge
+ * (hollowness) scores need.
+ *
+ * Labeling can be limited to part of the mask, or to several parts of it. Particles are still
+ * reported in whole image coordinates, and anything outside the areas is treated as empty.
+ *
+ * All storage is allocated by the constructor. If a frame has more runs or particles than that,
+ * the extra ones are ignored and Overflowed() returns true.
+ *
+ * This file does not use WPILib so the labeler can be run on the robot and on a PC.
+ */
+class ParticleLabeler
+{
+private:
+	int maxWidth, maxHeight, maxRuns, maxParticles;
+	int runCount, particleCount;
+	bool overflowed;
+
+	//one entry per run, the stats are only valid on the root run of each particle
+	int *runY, *runStart, *runEnd, *runParent, *runNext;
+	int *statArea, *statLeft, *statRight, *statTop, *statBottom;
+
+	//per particle scratch for building the convex hull
+	int *rowLeft, *rowRight;
+	int *hullY, *hullX;
+	int *pointY, *pointX;
+
+	ParticleReport *particles;
+	unsigned short *columnCounts, *rowCounts;	//maxWidth and maxHeight entries for each particle
+
+	int Find(int run);
+	void Union(int a, int b);
+	void MeasureHull(int root, ParticleReport *report, int profile);
+
+public:
+	ParticleLabeler(int max_width, int max_height, int max_runs, int max_particles);
+	~ParticleLabeler();
+
+	int Label(const unsigned char *mask, int maskStride, int width, int height, double areaMinimum);
+	int Label(const unsigned char *mask, int maskStride, int width, int height, const ParticleRect &area,
+			double areaMinimum);
+	int Label(const unsigned char *mask, int maskStride, int width, int height, const ParticleRect *areas,
+			int areaCount, double areaMinimum);
+
+	int GetParticleCount(void) const { return particleCount; }
+	ParticleReport *GetParticle(int i) { return &particles[i]; }
+	bool Overflowed(void) const { return overflowed; }
+};
+
+#endif
@@ -0,0 +1,91 @@
+#include "PeriodicLoop.h"
+#include <stdio.h>
+
+/**
+ * Fixed rate loop timing. See PeriodicLoop.h.
+ */
+
+//Fraction of a period covered by one histogram bucket, so the histograms cover two periods
+#define BUCKETS_PER_PERIOD (HISTOGRAM_BUCKETS / 2)
+
+/**
+ * @param in_period Seconds from the start of one pass to the start of the next
+ * @param in_clock Clock in seconds, Timer::GetFPGATimestamp on the robot
+ * @param in_sleep Sleeps for a number of seconds, Wait on the robot
+ */
+PeriodicLoop::PeriodicLoop(double in_period, double (*in_clock)(void), void (*in_sleep)(double seconds)) :
+	executionTimes(in_period / BUCKETS_PER_PERIOD),
+	jitter(in_period / BUCKETS_PER_PERIOD)
+{
+	period = in_period;
+	clock = in_clock;
+	sleep = in_sleep;
+	started = 0;
+	deadline = 0;
+	passStart = 0;
+	busy = 0;
+	passes = 0;
+	overruns = 0;
+	missedDeadlines = 0;
+}
+
+/**
+ * Starts the deadline grid at the current time and clears the statistics.
+ */
+void PeriodicLoop::Start(void)
+{
+	started = clock();
+	deadline = started;
+	passStart = started;
+	busy = 0;
+	passes = 0;
+	overruns = 0;
+	missedDeadlines = 0;
+	executionTimes.Clear();
+	jitter.Clear();
+}
+
+/**
+ * Ends a pass of the loop and sleeps until the next deadline.
+ */
+void PeriodicLoop::WaitForNextPeriod(void)
+{
+	double now = clock();
+	executionTimes.Add(now - passStart);
+	busy += now - passStart;
+	passes++;
+
+	deadline += period;
+	if (now >= deadline)
+	{
+		//overran, skip to the next deadline still ahead rather than running late passes back to back
+		unsigned long missed = (unsigned long) ((now - deadline) / period) + 1;
+		overruns++;
+		missedDeadlines += missed;
+		deadline += missed * period;
+	}
+	sleep(deadline - now);
+
+	passStart = clock();
+	jitter.Add(passStart - deadline);
+}
+
+/**
+ * Fraction of the time since Start() spent running the loop body rather than waiting.
+ */
+double PeriodicLoop::GetLoad(void) const
+{
+	double elapsed = passStart - started;
+	return elapsed > 0 ? busy / elapsed : 0;
+}
+
+/**
+ * Prints the loop's statistics to the console, for the end of a match period.
+ */
+void PeriodicLoop::PrintStatistics(const char *name) const
+{
+	printf("%s loop: %lu passes at %.1f Hz, %.1f%% load, %lu overruns, %lu deadlines missed\n", name, passes,
+			1 / period, GetLoad() * 100, overruns, missedDeadlines);
+	executionTimes.Print("execution");
+	jitter.Print("jitter");
+}
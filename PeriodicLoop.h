@@ -0,0 +1,62 @@
+#ifndef PERIODICLOOP_H
+#define PERIODICLOOP_H
+
+#include "TimeHistogram.h"
+
+/**
+ * Runs a loop body at a fixed rate. Call Start() before the loop and WaitForNextPeriod() at the
+ * end of every pass:
+ *
+ *   loop.Start();
+ *   while (IsOperatorControl() && IsEnabled())
+ *   {
+ *       ...
+ *       loop.WaitForNextPeriod();
+ *   }
+ *
+ * Deadlines are kept on an absolute grid (start, start + period, start + 2 * period, ...) and
+ * each wait sleeps until the next one, so time spent in the body or waking up late never makes
+ * the loop drift. When the body runs past a deadline the loop doesn't try to catch up by running
+ * back to back; the missed deadlines are counted and it carries on at the next one on the grid.
+ *
+ * Every pass records how long the body ran, how late the loop woke up after its deadline (jitter)
+ * and whether it overran, so the share of the CPU the loop takes can be checked on the robot.
+ *
+ * This file does not use WPILib, so the clock and the sleep are passed in: Timer::GetFPGATimestamp
+ * and Wait on the robot.
+ */
+class PeriodicLoop
+{
+private:
+	double period;
+	double (*clock)(void);
+	void (*sleep)(double seconds);
+
+	double started;
+	double deadline;
+	double passStart;
+	double busy;			//total seconds spent in the body
+	unsigned long passes;
+	unsigned long overruns;
+	unsigned long missedDeadlines;
+	TimeHistogram executionTimes;
+	TimeHistogram jitter;
+
+public:
+	PeriodicLoop(double in_period, double (*in_clock)(void), void (*in_sleep)(double seconds));
+
+	void Start(void);
+	void WaitForNextPeriod(void);
+
+	double GetPeriod(void) const { return period; }
+	unsigned long GetPassCount(void) const { return passes; }
+	unsigned long GetOverrunCount(void) const { return overruns; }
+	unsigned long GetMissedDeadlineCount(void) const { return missedDeadlines; }
+	const TimeHistogram &GetExecutionTimes(void) const { return executionTimes; }
+	const TimeHistogram &GetJitter(void) const { return jitter; }
+	double GetLoad(void) const;
+
+	void PrintStatistics(const char *name) const;
+};
+
+#endif
@@ -0,0 +1,188 @@
+#include "ShooterAngleEstimator.h"
+#include <math.h>
+
+/**
+ * Shooter angle dead reckoning. See ShooterAngleEstimator.h.
+ */
+
+/**
+ * @param in_position Where the shooter is assumed to start, until it reaches a limit
+ * @param in_forwardSpeed Starting guess at the forward speed, travel per second
+ * @param in_reverseSpeed Starting guess at the reverse speed, travel per second
+ */
+ShooterAngleEstimator::ShooterAngleEstimator(double in_position, double in_forwardSpeed, double in_reverseSpeed)
+{
+	forwardSpeed = in_forwardSpeed;
+	reverseSpeed = in_reverseSpeed;
+	position = in_position;
+	homed = false;
+	direction = 0;
+	moving = false;
+	target = in_position;
+	lastTime = 0;
+	haveTime = false;
+	lastPeriod = 0;
+	atReverse = false;
+	atForward = false;
+	reference = 0;
+	haveReference = false;
+	forwardTime = 0;
+	reverseTime = 0;
+	historyCount = 0;
+	historyNewest = -1;
+}
+
+/**
+ * Called once per control loop tick, before deciding what the relay does this tick.
+ *
+ * @param atReverseLimit The reverse limit switch is pressed
+ * @param atForwardLimit The forward limit switch is pressed
+ * @param time Now, in seconds
+ */
+void ShooterAngleEstimator::Update(bool atReverseLimit, bool atForwardLimit, double time)
+{
+	double dt = haveTime ? time - lastTime : 0;
+	lastTime = time;
+	haveTime = true;
+	if (dt > 0)
+		lastPeriod = dt;
+
+	if (direction > 0)
+	{
+		position += forwardSpeed * dt;
+		forwardTime += dt;
+	}
+	else if (direction < 0)
+	{
+		position -= reverseSpeed * dt;
+		reverseTime += dt;
+	}
+	if (position < 0)
+		position = 0;
+	if (position > 1)
+		position = 1;
+
+	atReverse = atReverseLimit;
+	atForward = atForwardLimit;
+	if (atReverse)
+	{
+		if (direction < 0)
+			Learn(0, reverseTime, forwardTime, &reverseSpeed);
+		position = 0;
+	}
+	else if (atForward)
+	{
+		if (direction > 0)
+			Learn(1, forwardTime, reverseTime, &forwardSpeed);
+		position = 1;
+	}
+	if (atReverse || atForward)
+	{
+		homed = true;
+		reference = position;
+		haveReference = true;
+		forwardTime = 0;
+		reverseTime = 0;
+	}
+
+	historyNewest = (historyNewest + 1) % ANGLE_HISTORY;
+	historyTimes[historyNewest] = time;
+	historyPositions[historyNewest] = position;
+	if (historyCount < ANGLE_HISTORY)
+		historyCount++;
+	Steer();
+}
+
+/**
+ * Arriving at a limit: if the motor has only run towards it since leaving the other limit, that
+ * run gives the speed.
+ */
+void ShooterAngleEstimator::Learn(double limit, double time, double otherTime, double *speed)
+{
+	if (!haveReference || fabs(limit - reference) < 1 || otherTime > 0 || time <= 0)
+		return;
+	*speed += ANGLE_SPEED_LEARNING * (1 / time - *speed);
+}
+
+/**
+ * Picks the direction for the coming tick.
+ */
+void ShooterAngleEstimator::Steer(void)
+{
+	if (moving)
+	{
+		if (target >= 1)
+			direction = 1;
+		else if (target <= 0)
+			direction = -1;
+		else
+		{
+			double remaining = target - position;
+			double speed = remaining > 0 ? forwardSpeed : reverseSpeed;
+			//stop on the tick nearest the target, and never turn round on an overshoot
+			if (fabs(remaining) <= speed * lastPeriod / 2 || remaining * direction < 0)
+			{
+				direction = 0;
+				moving = false;
+			}
+			else
+				direction = remaining > 0 ? 1 : -1;
+		}
+	}
+	if ((direction > 0 && atForward) || (direction < 0 && atReverse))
+	{
+		direction = 0;
+		moving = false;
+	}
+}
+
+/**
+ * Starts a move to a position, 0 to 1. 0 and 1 run all the way to the limit switch.
+ */
+void ShooterAngleEstimator::MoveTo(double in_target)
+{
+	target = in_target < 0 ? 0 : (in_target > 1 ? 1 : in_target);
+	moving = true;
+	direction = 0;
+	Steer();
+}
+
+/**
+ * Runs the motor by hand: 1 forward, -1 reverse, 0 off.
+ */
+void ShooterAngleEstimator::Drive(int in_direction)
+{
+	moving = false;
+	direction = in_direction > 0 ? 1 : (in_direction < 0 ? -1 : 0);
+	Steer();
+}
+
+void ShooterAngleEstimator::Stop(void)
+{
+	moving = false;
+	direction = 0;
+}
+
+/**
+ * Where the shooter was at a time in the recent past, interpolated between updates. Times
+ * before the oldest update kept give the oldest position, and times after the last update the
+ * current one.
+ */
+double ShooterAngleEstimator::GetPositionAt(double time) const
+{
+	if (historyCount == 0 || time >= historyTimes[historyNewest])
+		return position;
+	int newer = historyNewest;
+	for (int i = 1; i < historyCount; i++)
+	{
+		int older = (newer + ANGLE_HISTORY - 1) % ANGLE_HISTORY;
+		if (historyTimes[older] <= time)
+		{
+			double span = historyTimes[newer] - historyTimes[older];
+			double fraction = span > 0 ? (time - historyTimes[older]) / span : 1;
+			return historyPositions[older] + fraction * (historyPositions[newer] - historyPositions[older]);
+		}
+		newer = older;
+	}
+	return historyPositions[newer];
+}
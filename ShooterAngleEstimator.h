@@ -0,0 +1,84 @@
+#ifndef SHOOTERANGLEESTIMATOR_H
+#define SHOOTERANGLEESTIMATOR_H
+
+//Default speeds of the shooter angle motor, in travel per second, from the old full travel times
+#define ANGLE_FORWARD_SPEED (1 / 5.5)
+#define ANGLE_REVERSE_SPEED (1 / 5.61)
+//How far each full run between the limits moves the learned speed towards the one measured
+#define ANGLE_SPEED_LEARNING 0.75
+//Updates of position kept for GetPositionAt(), 1.28 s at 50 Hz
+#define ANGLE_HISTORY 64
+
+/**
+ * Keeps track of where the shooter angle is, and moves it to a position, for a shooter tilted by
+ * a relay-driven motor with nothing to measure it but a limit switch at each end.
+ *
+ * Positions are in fractions of the full travel: 0 at the limit the motor reaches running in
+ * reverse (ShooterAngleUp) and 1 at the one it reaches running forward (ShooterAngleDown). In
+ * between, the position is dead reckoned from how long the motor has run each way, at a speed
+ * for each direction since the motor is loaded differently going up and down. Reaching either
+ * limit sets the position exactly (homes the estimate), and a run from one limit to the other in
+ * a single direction measures that direction's speed, which the estimate then moves towards.
+ * Until the first limit is reached the position is the starting guess.
+ *
+ * The position at each Update() is kept for a short while, so a camera frame taken a few ticks
+ * ago can be compared with where the shooter was when it was taken (GetPositionAt()).
+ *
+ * Update() is called once per control loop tick with the limit switches and the time, and then
+ * GetDirection() says what to do with the relay until the next tick: 1 forward, -1 reverse or 0
+ * off. MoveTo() stops the motor on the tick nearest the target. A target of 0 or 1 instead runs
+ * to the limit switch, however far off the estimate is, so full moves always home. Drive() runs
+ * the motor by hand, cancelling any MoveTo().
+ *
+ * This file does not use WPILib.
+ */
+class ShooterAngleEstimator
+{
+private:
+	double forwardSpeed;
+	double reverseSpeed;
+	double position;
+	bool homed;
+	int direction;
+	bool moving;			//running to target rather than by hand
+	double target;
+	double lastTime;
+	bool haveTime;
+	double lastPeriod;
+	bool atReverse;
+	bool atForward;
+
+	//for learning speeds: where the motor last started from a limit, and how long it has run each way since
+	double reference;
+	bool haveReference;
+	double forwardTime;
+	double reverseTime;
+
+	double historyTimes[ANGLE_HISTORY];
+	double historyPositions[ANGLE_HISTORY];
+	int historyCount;
+	int historyNewest;
+
+	void Learn(double limit, double time, double otherTime, double *speed);
+	void Steer(void);
+
+public:
+	ShooterAngleEstimator(double in_position = 0, double in_forwardSpeed = ANGLE_FORWARD_SPEED,
+			double in_reverseSpeed = ANGLE_REVERSE_SPEED);
+
+	void Update(bool atReverseLimit, bool atForwardLimit, double time);
+	void MoveTo(double in_target);
+	void Drive(int in_direction);
+	void Stop(void);
+	double GetPositionAt(double time) const;
+
+	int GetDirection(void) const { return direction; }
+	double GetPosition(void) const { return position; }
+	double GetTarget(void) const { return target; }
+	bool IsHomed(void) const { return homed; }
+	bool IsMoving(void) const { return moving; }
+	double GetForwardSpeed(void) const { return forwardSpeed; }
+	double GetReverseSpeed(void) const { return reverseSpeed; }
+};
+
+#endif
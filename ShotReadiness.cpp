@@ -0,0 +1,69 @@
+#include "ShotReadiness.h"
+#include <math.h>
+
+/**
+ * Predictive ready-to-fire check. See ShotReadiness.h.
+ */
+
+/**
+ * @param in_setpoint Shooter speed wanted when the disc gets there
+ * @param in_tolerance How far from the setpoint the speed may be when the disc gets there
+ * @param in_reach Furthest the speed may be from the setpoint now for a prediction to count
+ * @param in_leadTime Seconds from starting the feed to the disc reaching the flywheel
+ * @param in_confirmCount Updates in a row the prediction must be in tolerance
+ */
+ShotReadiness::ShotReadiness(double in_setpoint, double in_tolerance, double in_reach, double in_leadTime,
+		int in_confirmCount)
+{
+	setpoint = in_setpoint;
+	tolerance = in_tolerance;
+	reach = in_reach;
+	leadTime = in_leadTime;
+	confirmCount = in_confirmCount;
+	Reset();
+}
+
+void ShotReadiness::SetSetpoint(double in_setpoint)
+{
+	setpoint = in_setpoint;
+	Reset();
+}
+
+void ShotReadiness::SetLeadTime(double in_leadTime)
+{
+	leadTime = in_leadTime;
+	Reset();
+}
+
+/**
+ * Starts the count of good predictions over, as after a shot.
+ */
+void ShotReadiness::Reset(void)
+{
+	goodCount = 0;
+	predictedSpeed = 0;
+}
+
+/**
+ * Called once per control loop tick.
+ *
+ * @param speed Shooter speed estimate
+ * @param acceleration Its rate of change, per second
+ * @return true if a feed started now should reach the flywheel at speed
+ */
+bool ShotReadiness::Update(double speed, double acceleration)
+{
+	double error = setpoint - speed;
+	double predictedError;
+	if (error * acceleration > 0)
+		predictedError = error * exp(-leadTime * acceleration / error);
+	else
+		predictedError = error - acceleration * leadTime;
+	predictedSpeed = setpoint - predictedError;
+
+	if (fabs(predictedError) <= tolerance && fabs(error) <= reach)
+		goodCount++;
+	else
+		goodCount = 0;
+	return goodCount >= confirmCount;
+}
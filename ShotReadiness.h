@@ -0,0 +1,48 @@
+#ifndef SHOTREADINESS_H
+#define SHOTREADINESS_H
+
+/**
+ * Decides when to start feeding a disc so that it reaches the shooter just as the flywheel comes
+ * into tolerance, rather than waiting for the speed to sit in tolerance for a settle time and
+ * only then spending the feed time on top.
+ *
+ * Each Update() takes the speed estimate and its acceleration (FlywheelSpeed) and predicts the
+ * speed lead time from now, the time the hurricane takes to get a disc to the wheel. Closing on
+ * the setpoint, the flywheel is taken to settle like a first order system, with the time constant
+ * the current error and acceleration imply:
+ *
+ *   tau = error / acceleration,   predicted error = error * exp(-lead / tau)
+ *
+ * and moving away from it, or standing still, the speed is carried straight on at the present
+ * acceleration. The shot is ready once the predicted error has been inside the tolerance for
+ * a few updates in a row and the speed is already within reach of the setpoint, which keeps
+ * a noisy acceleration far from the setpoint from firing early.
+ *
+ * A lead time of 0 makes it a plain in-tolerance check. This file does not use WPILib.
+ */
+class ShotReadiness
+{
+private:
+	double setpoint;
+	double tolerance;
+	double reach;
+	double leadTime;
+	int confirmCount;
+
+	int goodCount;
+	double predictedSpeed;
+
+public:
+	ShotReadiness(double in_setpoint, double in_tolerance, double in_reach, double in_leadTime,
+			int in_confirmCount);
+
+	void SetSetpoint(double in_setpoint);
+	void SetLeadTime(double in_leadTime);
+	void Reset(void);
+	bool Update(double speed, double acceleration);
+
+	double GetPredictedSpeed(void) const { return predictedSpeed; }
+	double GetLeadTime(void) const { return leadTime; }
+};
+
+#endif
@@ -0,0 +1,109 @@
+#include "ShotSequencer.h"
+
+/**
+ * Hurricane feed state machine. See ShotSequencer.h.
+ */
+
+ShotSequencer::ShotSequencer(void)
+{
+	state = SHOT_IDLE;
+	current.start = current.closed = current.end = 0;
+	last = current;
+	shotCount = 0;
+	queued = 0;
+	ready = false;
+}
+
+void ShotSequencer::Begin(bool switchClosed, double time)
+{
+	current.start = time;
+	current.closed = 0;
+	current.end = 0;
+	state = switchClosed ? SHOT_WAITING_FOR_OPEN : SHOT_WAITING_FOR_CLOSE;
+}
+
+/**
+ * Starts a shot. Does nothing if one is already under way.
+ *
+ * @param switchClosed Whether the hurricane switch is closed right now
+ * @param time When the hurricane was turned on
+ */
+void ShotSequencer::Fire(bool switchClosed, double time)
+{
+	if (IsFeeding())
+		return;
+	Begin(switchClosed, time);
+}
+
+/**
+ * Sets how many shots to take one after another, each once SetReady() says so.
+ *
+ * @param shots Shots to take, 0 to stop after the one under way
+ * @param switchClosed Whether the hurricane switch is closed right now
+ * @param time Now
+ */
+void ShotSequencer::Queue(int shots, bool switchClosed, double time)
+{
+	queued = shots;
+	if (queued == 0 && state == SHOT_STAGING)
+		state = SHOT_STAGED;
+	SetReady(ready, switchClosed, time);
+}
+
+/**
+ * Says whether a disc fed now would reach the shooter at speed, and starts the next queued
+ * shot if it would and the hurricane is waiting for that.
+ *
+ * @param switchClosed Whether the hurricane switch is closed right now
+ * @param time Now
+ */
+void ShotSequencer::SetReady(bool in_ready, bool switchClosed, double time)
+{
+	ready = in_ready;
+	if (ready && queued > 0 && (state == SHOT_IDLE || state == SHOT_STAGED))
+	{
+		queued--;
+		Begin(switchClosed, time);
+	}
+}
+
+/**
+ * Handles an edge of the hurricane switch.
+ *
+ * @param closed The switch's new state
+ * @param time When it changed
+ * @return true if this edge finished a shot
+ */
+bool ShotSequencer::SwitchChanged(bool closed, double time)
+{
+	if (state == SHOT_WAITING_FOR_CLOSE && closed)
+	{
+		current.closed = time;
+		state = SHOT_WAITING_FOR_OPEN;
+	}
+	else if (state == SHOT_WAITING_FOR_OPEN && !closed)
+	{
+		current.end = time;
+		last = current;
+		shotCount++;
+		ready = false;
+		state = queued > 0 ? SHOT_STAGING : SHOT_IDLE;
+		return true;
+	}
+	else if (state == SHOT_STAGING && closed)
+	{
+		state = SHOT_STAGED;
+		SetReady(ready, true, time);
+	}
+	return false;
+}
+
+/**
+ * Gives up on the shot under way and any queued, without counting them.
+ */
+void ShotSequencer::Abort(void)
+{
+	state = SHOT_IDLE;
+	queued = 0;
+	ready = false;
+}
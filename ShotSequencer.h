@@ -0,0 +1,74 @@
+#ifndef SHOTSEQUENCER_H
+#define SHOTSEQUENCER_H
+
+/**
+ * How one shot went, in the seconds of the clock the edges were stamped with.
+ */
+struct ShotTiming {
+	double start;		//Fire() turned the hurricane on, or the next disc came round with the shooter ready
+	double closed;		//the hurricane switch closed, the disc is on its way; 0 if it was already closed
+	double end;			//the switch opened again and the hurricane was stopped or went on to the next disc
+};
+
+/**
+ * The hurricane feed as a state machine driven by edges of the hurricane switch, in place of
+ * UpdateShooting() polling the switch from the control loop.
+ *
+ * The switch is closed for part of each turn of the hurricane and a disc goes into the shooter
+ * while it is. Fire() starts the hurricane; if the switch was open the shot waits for it to
+ * close and then to open again, and if it was already closed (the hurricane stopped part way
+ * round) it just waits for it to open. The opening edge ends the shot, and the hurricane should
+ * be stopped right then so it comes to rest in the same place every time.
+ *
+ * Shots can also be queued with Queue(), for autonomous. Each queued shot starts as soon as
+ * SetReady() says the shooter will be at speed when the disc gets there, and while more are
+ * queued the hurricane doesn't stop when a shot ends but turns on to the next disc (staging).
+ * If the shooter is ready by the time that disc closes the switch the shot just carries on,
+ * and if not the hurricane stops there (staged), with the disc a short turn from the shooter,
+ * until it is. A readiness only counts for the shot it was worked out for: it is cleared when
+ * a shot ends.
+ *
+ * Each method is given the time of the edge or command, so a shot's timing comes from when the
+ * switch actually changed rather than when somebody next looked. After every call IsTurning()
+ * says whether the hurricane should be on. This file does not use WPILib; HurricaneFeed runs it
+ * from a fast Notifier on the robot.
+ */
+class ShotSequencer
+{
+public:
+	enum State {
+		SHOT_IDLE,
+		SHOT_WAITING_FOR_CLOSE,		//hurricane turning, the switch hasn't reached the disc yet
+		SHOT_WAITING_FOR_OPEN,		//disc on its way, the switch opening ends the shot
+		SHOT_STAGING,				//turning on to the next queued disc, stops when the switch closes
+		SHOT_STAGED					//stopped with the next queued disc ready to go
+	};
+
+private:
+	State state;
+	ShotTiming current;
+	ShotTiming last;
+	int shotCount;
+	int queued;
+	bool ready;
+
+	void Begin(bool switchClosed, double time);
+
+public:
+	ShotSequencer(void);
+
+	void Fire(bool switchClosed, double time);
+	void Queue(int shots, bool switchClosed, double time);
+	void SetReady(bool in_ready, bool switchClosed, double time);
+	bool SwitchChanged(bool closed, double time);
+	void Abort(void);
+
+	State GetState(void) const { return state; }
+	bool IsFeeding(void) const { return state == SHOT_WAITING_FOR_CLOSE || state == SHOT_WAITING_FOR_OPEN; }
+	bool IsTurning(void) const { return IsFeeding() || state == SHOT_STAGING; }
+	int GetShotCount(void) const { return shotCount; }
+	int GetQueuedCount(void) const { return queued; }
+	const ShotTiming &GetLastShot(void) const { return last; }
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef SHOTSETTINGS_H
+#define SHOTSETTINGS_H
+
+/**
+ * The shooter speed and the limits a shot is taken within, shared by MyRobot.cpp and
+ * tools/RobotSim so the simulation measures the robot against the speed it is really aiming for.
+ * Speeds are in encoder counts/s.
+ */
+#define WHEELSPEED 300
+#define LOWERTHRESHOLD (WHEELSPEED-10)
+#define UPPERTHRESHOLD (WHEELSPEED+10)
+#define MINIMUMSPEED (WHEELSPEED-50)
+#define SHOTLEADTIME 0.3	//seconds ahead the autonomous ready check predicts the speed, see tools/RobotSim
+#define SHOTSTAGEDLEADTIME 0.1	//the same once the hurricane has the next disc at the switch
+#define SHOTREACH 20	//counts/s under WHEELSPEED the shooter must be for a prediction to count
+#define SHOTCONFIRM 2	//autonomous loops in a row the shooter must be predicted at speed
+
+#endif
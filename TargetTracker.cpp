@@ -0,0 +1,246 @@
+#include "TargetTracker.h"
+#include <math.h>
+#include <stddef.h>
+
+/**
+ * Multi-frame high goal tracker. See TargetTracker.h.
+ */
+
+TargetTracker::TargetTracker(void)
+{
+	nextId = 1;
+	Reset();
+}
+
+/**
+ * Forgets every track, as when the camera has been off.
+ */
+void TargetTracker::Reset(void)
+{
+	trackCount = 0;
+	bestId = 0;
+	lastTime = 0;
+	haveTime = false;
+}
+
+/**
+ * Called with the high goal candidates of each frame, in the order the frames were captured.
+ *
+ * @param detections Candidates found in the frame
+ * @param count Number of them, none if the frame had no goal in it
+ * @param time When the frame was captured, in seconds
+ */
+void TargetTracker::Update(const TargetDetection *detections, int count, double time)
+{
+	double dt = haveTime ? time - lastTime : 0;
+	if (dt < 0)
+		dt = 0;
+	lastTime = time;
+	haveTime = true;
+	if (count > MAX_DETECTIONS)
+		count = MAX_DETECTIONS;
+
+	Predict(dt);
+	Associate(detections, count, dt, time);
+
+	//drop the tracks that have gone unseen too long
+	int kept = 0;
+	for (int i = 0; i < trackCount; i++)
+	{
+		if (time - tracks[i].lastSeen <= TRACK_MAX_COAST)
+			tracks[kept++] = tracks[i];
+	}
+	trackCount = kept;
+	ChooseBest();
+}
+
+/**
+ * Moves every track on by dt seconds at its velocity.
+ */
+void TargetTracker::Predict(double dt)
+{
+	for (int i = 0; i < trackCount; i++)
+	{
+		TargetTrack *track = &tracks[i];
+		track->x += track->vx * dt;
+		track->y += track->vy * dt;
+		track->width += track->vwidth * dt;
+		if (track->width < 1)
+			track->width = 1;
+	}
+}
+
+/**
+ * Pairs tracks with detections, closest pair first, then corrects the paired tracks, ages the
+ * unpaired ones and starts tracks for the unpaired detections.
+ */
+void TargetTracker::Associate(const TargetDetection *detections, int count, double dt, double time)
+{
+	bool trackUsed[MAX_TRACKS];
+	bool detectionUsed[MAX_DETECTIONS];
+	for (int i = 0; i < trackCount; i++)
+		trackUsed[i] = false;
+	for (int j = 0; j < count; j++)
+		detectionUsed[j] = false;
+
+	//there are few enough of both that looking at every pair for each match is cheap
+	for (;;)
+	{
+		int bestTrack = -1, bestDetection = -1;
+		double bestCost = 0;
+		for (int i = 0; i < trackCount; i++)
+		{
+			if (trackUsed[i])
+				continue;
+			const TargetTrack *track = &tracks[i];
+			for (int j = 0; j < count; j++)
+			{
+				if (detectionUsed[j])
+					continue;
+				double dx = detections[j].x - track->x;
+				double dy = detections[j].y - track->y;
+				double offset = sqrt(dx * dx + dy * dy) / track->width;
+				double size = fabs(detections[j].width - track->width) / track->width;
+				if (offset > TRACK_POSITION_GATE || size > TRACK_SIZE_GATE)
+					continue;
+				double cost = offset + size;
+				if (bestTrack < 0 || cost < bestCost)
+				{
+					bestTrack = i;
+					bestDetection = j;
+					bestCost = cost;
+				}
+			}
+		}
+		if (bestTrack < 0)
+			break;
+		trackUsed[bestTrack] = true;
+		detectionUsed[bestDetection] = true;
+		Correct(&tracks[bestTrack], detections[bestDetection], dt, time);
+	}
+
+	for (int i = 0; i < trackCount; i++)
+	{
+		if (!trackUsed[i])
+		{
+			tracks[i].confidence *= TRACK_CONFIDENCE_DECAY;
+			tracks[i].misses++;
+		}
+	}
+
+	for (int j = 0; j < count && trackCount < MAX_TRACKS; j++)
+	{
+		if (detectionUsed[j])
+			continue;
+		TargetTrack *track = &tracks[trackCount++];
+		track->id = nextId++;
+		track->x = detections[j].x;
+		track->y = detections[j].y;
+		track->width = detections[j].width > 1 ? detections[j].width : 1;
+		track->height = detections[j].height;
+		track->vx = 0;
+		track->vy = 0;
+		track->vwidth = 0;
+		track->confidence = TRACK_CONFIDENCE_GAIN;
+		track->firstSeen = time;
+		track->lastSeen = time;
+		track->hits = 1;
+		track->misses = 0;
+		track->detection = detections[j];
+	}
+}
+
+/**
+ * Pulls a track towards the detection it was paired with.
+ */
+void TargetTracker::Correct(TargetTrack *track, const TargetDetection &detection, double dt, double time)
+{
+	double rx = detection.x - track->x;
+	double ry = detection.y - track->y;
+	double rwidth = detection.width - track->width;
+
+	track->x += TRACK_ALPHA * rx;
+	track->y += TRACK_ALPHA * ry;
+	track->width += TRACK_ALPHA * rwidth;
+	track->height += TRACK_ALPHA * (detection.height - track->height);
+	if (dt > 0)
+	{
+		track->vx += TRACK_BETA * rx / dt;
+		track->vy += TRACK_BETA * ry / dt;
+		track->vwidth += TRACK_BETA * rwidth / dt;
+	}
+	if (track->width < 1)
+		track->width = 1;
+
+	track->confidence += (1 - track->confidence) * TRACK_CONFIDENCE_GAIN;
+	track->lastSeen = time;
+	track->hits++;
+	track->misses = 0;
+	track->detection = detection;
+}
+
+/**
+ * Picks the track to report, keeping the last one unless another is clearly more confident.
+ */
+void TargetTracker::ChooseBest(void)
+{
+	const TargetTrack *best = NULL;
+	const TargetTrack *current = NULL;
+	for (int i = 0; i < trackCount; i++)
+	{
+		const TargetTrack *track = &tracks[i];
+		if (track->hits < TRACK_CONFIRM_HITS)
+			continue;
+		if (track->id == bestId)
+			current = track;
+		if (best == NULL || track->confidence > best->confidence)
+			best = track;
+	}
+	if (current != NULL && current->confidence + TRACK_SWITCH_MARGIN >= best->confidence)
+		best = current;
+	bestId = best != NULL ? best->id : 0;
+}
+
+/**
+ * The track being reported, or NULL if no target has been seen on enough frames.
+ */
+const TargetTrack *TargetTracker::GetBest(void) const
+{
+	for (int i = 0; i < trackCount; i++)
+	{
+		if (tracks[i].id == bestId)
+			return &tracks[i];
+	}
+	return NULL;
+}
+
+/**
+ * Fills in the high goal fields of a frame's result from the reported track, in place of the
+ * raw detection.
+ */
+void TargetTracker::Report(VisionResult *result, int imageWidth, int imageHeight) const
+{
+	const TargetTrack *best = GetBest();
+	if (best == NULL || imageWidth <= 0 || imageHeight <= 0)
+	{
+		result->isHighGoal = false;
+		result->highTrackId = 0;
+		result->highConfidence = 0;
+		result->highAge = 0;
+		result->highMisses = 0;
+		return;
+	}
+	result->isHighGoal = true;
+	result->highX = (int) floor(best->x + 0.5);
+	result->highY = (int) floor(best->y + 0.5);
+	result->highWidth = (int) floor(best->width + 0.5);
+	result->highHeight = (int) floor(best->height + 0.5);
+	result->highCenterXNormal = 2 * best->x / imageWidth - 1;
+	result->highCenterYNormal = 2 * best->y / imageHeight - 1;
+	result->highDistance = best->detection.distance;
+	result->highDistance2 = best->detection.distance2;
+	result->highTrackId = best->id;
+	result->highConfidence = best->confidence;
+	result->highAge = lastTime - best->firstSeen;
+	result->highMisses = best->misses;
+}
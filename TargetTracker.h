@@ -0,0 +1,101 @@
+#ifndef TARGETTRACKER_H
+#define TARGETTRACKER_H
+
+#include "VisionResult.h"
+
+//Most targets followed at once, and most detections looked at per frame
+#define MAX_TRACKS 8
+#define MAX_DETECTIONS 64
+//Furthest a detection may be from where a track was predicted to be, in widths of the track,
+//and most its width may differ from the track's, as a fraction of the track's width
+#define TRACK_POSITION_GATE 1.0
+#define TRACK_SIZE_GATE 0.5
+//How far each detection moves a track's position and size (alpha), and its velocity (beta)
+#define TRACK_ALPHA 0.5
+#define TRACK_BETA 0.2
+//Confidence gained on a frame a track is seen, as a fraction of what is left to 1, and kept
+//on a frame it is missed
+#define TRACK_CONFIDENCE_GAIN 0.4
+#define TRACK_CONFIDENCE_DECAY 0.7
+//Frames a track must be seen on before it is reported, and seconds it may go unseen before
+//it is dropped
+#define TRACK_CONFIRM_HITS 2
+#define TRACK_MAX_COAST 0.5
+//How much more confident another track must be to take over as the reported one
+#define TRACK_SWITCH_MARGIN 0.15
+
+/**
+ * One high goal candidate from one frame, in pixels, with the distances worked out from it.
+ */
+struct TargetDetection {
+	double x;
+	double y;
+	double width;
+	double height;
+	double distance;
+	double distance2;
+};
+
+/**
+ * A target followed across frames. Positions and sizes are the smoothed ones, velocities are
+ * in pixels per second.
+ */
+struct TargetTrack {
+	int id;
+	double x, y, width, height;
+	double vx, vy, vwidth;
+	double confidence;		//0 to 1
+	double firstSeen;		//timestamps of the first and latest frames the target was seen in
+	double lastSeen;
+	int hits;				//frames it has been seen in
+	int misses;				//frames in a row it has not
+	TargetDetection detection;	//latest detection, for the distances
+};
+
+/**
+ * Follows the high goal candidates from frame to frame, so the control loop gets one steady
+ * estimate of the goal instead of whichever qualifying particle happened to be scored last.
+ *
+ * Each Update() moves every track on to the frame's timestamp at its velocity, then pairs
+ * tracks with detections greedily, closest first, by how far the detection is from the
+ * prediction (in track widths) plus how much its width differs. Pairs outside the gates are
+ * never made. A paired track is pulled towards its detection by an alpha-beta filter on its
+ * center and width, and gains confidence; a track left unpaired coasts on its velocity and
+ * loses confidence, and is dropped once it has gone unseen for TRACK_MAX_COAST seconds.
+ * Detections left unpaired start new tracks.
+ *
+ * Since the prediction steps by the time between frames rather than by frame, dropped frames
+ * and a slower camera only make the steps longer. The reported track is the most confident one
+ * that has been seen on a few frames, and it stays the reported one until another is clearly
+ * more confident, so two goals in view don't make the estimate jump back and forth.
+ *
+ * Frames must be given in the order they were captured. This file does not use WPILib.
+ */
+class TargetTracker
+{
+private:
+	TargetTrack tracks[MAX_TRACKS];
+	int trackCount;
+	int nextId;
+	int bestId;
+	double lastTime;
+	bool haveTime;
+
+	void Predict(double dt);
+	void Associate(const TargetDetection *detections, int count, double dt, double time);
+	void Correct(TargetTrack *track, const TargetDetection &detection, double dt, double time);
+	void ChooseBest(void);
+
+public:
+	TargetTracker(void);
+
+	void Reset(void);
+	void Update(const TargetDetection *detections, int count, double time);
+	void Report(VisionResult *result, int imageWidth, int imageHeight) const;
+	const TargetTrack *GetBest(void) const;
+
+	int GetTrackCount(void) const { return trackCount; }
+	const TargetTrack *GetTrack(int i) const { return &tracks[i]; }
+};
+
+#endif
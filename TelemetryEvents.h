@@ -0,0 +1,38 @@
+#ifndef TELEMETRYEVENTS_H
+#define TELEMETRYEVENTS_H
+
+#include <stddef.h>
+
+/**
+ * The events the robot logs through TelemetryLog, and the names tools/TelemetryDecode prints
+ * for them and their values. Add new events at the end so old logs still decode.
+ */
+enum TelemetryEvent {
+	TELEMETRY_SHOOTER_SPEED,		//shooter speed estimate changed
+	TELEMETRY_SPEED_GOOD_COUNT,		//autonomous loops in a row with the shooter at speed, no longer logged
+	TELEMETRY_HURRICANE_ON,			//the hurricane was started for a shot
+	TELEMETRY_HURRICANE_OFF,
+	TELEMETRY_SHOT_COMPLETE,		//seconds the shot took, and from the start to the switch closing
+	TELEMETRY_SHOT_READY,			//shooter ready for the next autonomous shot, with the speed and the speed predicted at the disc
+	TELEMETRY_AUTO_AIM,				//AutoAim() moving the shooter: frame age, goal row projected to now, target
+	TELEMETRY_HURRICANE_SWITCH,		//hurricane switch edge, and how long before it was logged
+	TELEMETRY_EVENT_COUNT
+};
+
+struct TelemetryEventInfo {
+	const char *name;
+	const char *values[3];			//NULL past the last value the event uses
+};
+
+static const TelemetryEventInfo telemetryEvents[TELEMETRY_EVENT_COUNT] = {
+	{ "shooter_speed", { "speed", "acceleration", "raw" } },
+	{ "speed_good_count", { "count", NULL, NULL } },
+	{ "hurricane_on", { NULL, NULL, NULL } },
+	{ "hurricane_off", { NULL, NULL, NULL } },
+	{ "shot_complete", { "feed", "to_switch", NULL } },
+	{ "shot_ready", { "speed", "predicted", NULL } },
+	{ "auto_aim", { "age", "projected_y", "target" } },
+	{ "hurricane_switch", { "closed", "age", NULL } },
+};
+
+#endif
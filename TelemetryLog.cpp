@@ -0,0 +1,178 @@
+#include "TelemetryLog.h"
+#include <string.h>
+#include <fcntl.h>
+#ifdef _WRS_KERNEL
+#include <sockLib.h>
+#include <inetLib.h>
+#include <ioLib.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+/**
+ * Binary telemetry log. See TelemetryLog.h.
+ */
+
+//Records written with one write() call
+#define DRAIN_BATCH 64
+
+/**
+ * @param in_clock Clock used to stamp records, in seconds
+ * @param capacity Records the log can hold between drains
+ */
+TelemetryLog::TelemetryLog(double (*in_clock)(void), int capacity) :
+	queue(capacity),
+	task("telemetry", TELEMETRY_DRAIN_PRIORITY)
+{
+	clock = in_clock;
+	dropped = 0;
+	droppedReported = 0;
+	discarded = 0;
+	written = 0;
+	fd = -1;
+	running = false;
+}
+
+TelemetryLog::~TelemetryLog()
+{
+	Stop();
+}
+
+/**
+ * Starts writing the log to a new file.
+ */
+bool TelemetryLog::StartFile(const char *path)
+{
+	if (running)
+		return false;
+	int file = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	return file >= 0 && Start(file);
+}
+
+/**
+ * Starts writing the log to a TCP connection, for example to `nc -l PORT > telemetry.bin` on the
+ * driver station.
+ *
+ * @param address Dotted IP address to connect to
+ */
+bool TelemetryLog::StartSocket(const char *address, int port)
+{
+	if (running)
+		return false;
+	struct sockaddr_in to;
+	memset(&to, 0, sizeof(to));
+	to.sin_family = AF_INET;
+	to.sin_port = htons(port);
+	to.sin_addr.s_addr = inet_addr((char *) address);
+	int s = socket(AF_INET, SOCK_STREAM, 0);
+	if (s < 0)
+		return false;
+	if (connect(s, (struct sockaddr *) &to, sizeof(to)) != 0)
+	{
+		close(s);
+		return false;
+	}
+	return Start(s);
+}
+
+bool TelemetryLog::Start(int in_fd)
+{
+	unsigned int header[4] = { TELEMETRY_MAGIC, TELEMETRY_VERSION, sizeof(TelemetryRecord), 0 };
+	fd = in_fd;
+	written = 0;
+	if (!Write(header, sizeof(header)))
+		return false;
+	running = true;
+	if (!task.Start(RunTask, this))
+	{
+		running = false;
+		close(fd);
+		fd = -1;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Writes out whatever is left in the log and closes the file or socket.
+ */
+void TelemetryLog::Stop(void)
+{
+	if (!running)
+		return;
+	running = false;
+	task.Signal();
+	task.Join();
+}
+
+void TelemetryLog::RunTask(void *log)
+{
+	((TelemetryLog *) log)->Run();
+}
+
+void TelemetryLog::Run(void)
+{
+	while (running)
+	{
+		Drain();
+		task.WaitForSignal(TELEMETRY_DRAIN_PERIOD);
+	}
+	Drain();
+	if (fd >= 0)
+		close(fd);
+	fd = -1;
+}
+
+/**
+ * Writes everything in the queue. Once a write fails the records are thrown away instead and
+ * counted as dropped, so the queue never fills up behind a dead connection.
+ */
+void TelemetryLog::Drain(void)
+{
+	TelemetryRecord batch[DRAIN_BATCH];
+	int count;
+	do
+	{
+		count = 0;
+		while (count < DRAIN_BATCH && queue.TryPop(&batch[count]))
+			count++;
+		if (fd < 0)
+			discarded += count;
+		else if (count > 0 && Write(batch, count * sizeof(TelemetryRecord)))
+			written += count;
+	} while (count == DRAIN_BATCH);
+
+	unsigned long droppedNow = dropped;
+	if (fd >= 0 && droppedNow != droppedReported)
+	{
+		TelemetryRecord record;
+		memset(&record, 0, sizeof(record));
+		record.timestamp = clock();
+		record.event = TELEMETRY_DROPPED;
+		record.valueCount = 1;
+		record.values[0] = droppedNow - droppedReported;
+		if (Write(&record, sizeof(record)))
+			droppedReported = droppedNow;
+	}
+}
+
+bool TelemetryLog::Write(const void *data, int size)
+{
+	const char *p = (const char *) data;
+	while (size > 0)
+	{
+		int n = write(fd, (char *) p, size);
+		if (n <= 0)
+		{
+			close(fd);
+			fd = -1;
+			return false;
+		}
+		p += n;
+		size -= n;
+	}
+	return true;
+}
@@ -0,0 +1,114 @@
+#ifndef TELEMETRYLOG_H
+#define TELEMETRYLOG_H
+
+#include "BoundedQueue.h"
+#include "BackgroundTask.h"
+
+//Records the log can hold before Log() starts dropping them
+#define TELEMETRY_CAPACITY 4096
+//Values carried by one record
+#define TELEMETRY_VALUES 3
+//Seconds between drains of the log to its file or socket
+#define TELEMETRY_DRAIN_PERIOD 0.1
+//VxWorks priority of the drain task, well below the control loops, the Notifiers and vision
+#define TELEMETRY_DRAIN_PRIORITY 200
+
+//First word of a log, written in the robot's byte order so a decoder can tell which that was
+#define TELEMETRY_MAGIC 0x544c4f47
+#define TELEMETRY_VERSION 1
+//Event of the record the drain writes when records had to be dropped, values[0] is how many
+#define TELEMETRY_DROPPED 0xffff
+
+/**
+ * One logged event. The layout is the same on the cRIO and on a PC apart from byte order.
+ */
+struct TelemetryRecord {
+	double timestamp;
+	unsigned short event;
+	unsigned short valueCount;
+	float values[TELEMETRY_VALUES];
+};
+
+/**
+ * Fixed size binary log for the control loop, to use instead of printf. Log() stamps a small
+ * record and pushes it onto a lock-free BoundedQueue, which costs about as much as reading the
+ * clock and never blocks. A low priority BackgroundTask drains the queue every
+ * TELEMETRY_DRAIN_PERIOD seconds and writes the records, as they are, to a file or a TCP
+ * socket. If the queue fills up because the drain can't keep up, new records are dropped and
+ * counted, and the drain writes a TELEMETRY_DROPPED record saying how many once it catches up.
+ *
+ * A log starts with four 32 bit words: TELEMETRY_MAGIC, TELEMETRY_VERSION, the size of a record
+ * and 0, followed by TelemetryRecords. tools/TelemetryDecode turns one into text or CSV, with
+ * the names in TelemetryEvents.h.
+ *
+ * Any number of tasks may call Log(). This file does not use WPILib, so the clock is passed in:
+ * Timer::GetFPGATimestamp on the robot.
+ */
+class TelemetryLog
+{
+private:
+	double (*clock)(void);
+	BoundedQueue<TelemetryRecord> queue;
+	volatile unsigned long dropped;		//records Log() couldn't queue, counted by every task that logs
+	unsigned long droppedReported;
+	unsigned long discarded;			//records the drain had nowhere to write, counted by the drain only
+	unsigned long written;
+	int fd;
+	BackgroundTask task;
+	volatile bool running;
+
+	bool Start(int in_fd);
+	static void RunTask(void *log);
+	void Run(void);
+	void Drain(void);
+	bool Write(const void *data, int size);
+
+	void Push(int event, int valueCount, float value0, float value1, float value2)
+	{
+		TelemetryRecord record;
+		record.timestamp = clock();
+		record.event = event;
+		record.valueCount = valueCount;
+		record.values[0] = value0;
+		record.values[1] = value1;
+		record.values[2] = value2;
+		if (!queue.TryPush(record))
+			AtomicIncrement(&dropped);
+	}
+
+public:
+	TelemetryLog(double (*in_clock)(void), int capacity = TELEMETRY_CAPACITY);
+	~TelemetryLog();
+
+	bool StartFile(const char *path);
+	bool StartSocket(const char *address, int port);
+	void Stop(void);
+
+	/**
+	 * Logs an event with up to three values.
+	 */
+	void Log(int event)
+	{
+		Push(event, 0, 0, 0, 0);
+	}
+
+	void Log(int event, float value0)
+	{
+		Push(event, 1, value0, 0, 0);
+	}
+
+	void Log(int event, float value0, float value1)
+	{
+		Push(event, 2, value0, value1, 0);
+	}
+
+	void Log(int event, float value0, float value1, float value2)
+	{
+		Push(event, 3, value0, value1, value2);
+	}
+
+	unsigned long GetDroppedCount(void) const { return dropped + discarded; }
+	unsigned long GetWrittenCount(void) const { return written; }
+};
+
+#endif
@@ -0,0 +1,75 @@
+#include "TimeHistogram.h"
+#include <stdio.h>
+
+/**
+ * @param bucket_width Seconds covered by each bucket. The histogram covers HISTOGRAM_BUCKETS
+ * times this, past that samples only count towards the overflow bucket and the maximum.
+ */
+TimeHistogram::TimeHistogram(double bucket_width)
+{
+	bucketWidth = bucket_width;
+	Clear();
+}
+
+void TimeHistogram::Clear(void)
+{
+	for (int i = 0; i <= HISTOGRAM_BUCKETS; i++)
+		buckets[i] = 0;
+	count = 0;
+	total = 0;
+	min = 0;
+	max = 0;
+}
+
+/**
+ * Adds one sample. Negative samples (waking up before a deadline, for example) go in the first
+ * bucket but are still counted in the minimum and the mean.
+ */
+void TimeHistogram::Add(double seconds)
+{
+	int bucket = seconds > 0 ? (int) (seconds / bucketWidth) : 0;
+	if (bucket > HISTOGRAM_BUCKETS)
+		bucket = HISTOGRAM_BUCKETS;
+	buckets[bucket]++;
+	if (count == 0 || seconds < min)
+		min = seconds;
+	if (count == 0 || seconds > max)
+		max = seconds;
+	total += seconds;
+	count++;
+}
+
+/**
+ * Estimates a percentile as the top of the bucket it falls in, so it is never under the real one.
+ *
+ * @param fraction 0.5 for the median, 0.99 for the 99th percentile
+ */
+double TimeHistogram::GetPercentile(double fraction) const
+{
+	if (count == 0)
+		return 0;
+	unsigned long target = (unsigned long) (fraction * count);
+	if (target >= count)
+		target = count - 1;
+	unsigned long seen = 0;
+	for (int i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		seen += buckets[i];
+		if (seen > target)
+		{
+			double top = (i + 1) * bucketWidth;
+			return top < max ? top : max;
+		}
+	}
+	return max;
+}
+
+/**
+ * Prints one line with the count, mean, p50, p99 and max, in milliseconds.
+ */
+void TimeHistogram::Print(const char *name) const
+{
+	printf("%-10s n %lu  mean %.2f  p50 %.2f  p99 %.2f  max %.2f ms  (%lu over %.0f ms)\n", name, count,
+			GetMean() * 1000, GetPercentile(0.5) * 1000, GetPercentile(0.99) * 1000, max * 1000,
+			buckets[HISTOGRAM_BUCKETS], HISTOGRAM_BUCKETS * bucketWidth * 1000);
+}
@@ -0,0 +1,39 @@
+#ifndef TIMEHISTOGRAM_H
+#define TIMEHISTOGRAM_H
+
+//Buckets in a TimeHistogram, plus one for everything past the last
+#define HISTOGRAM_BUCKETS 100
+
+/**
+ * Histogram of durations in seconds, in fixed width buckets. Adding a sample never allocates,
+ * so it can be kept for every iteration of a control loop. Samples past the last bucket are
+ * counted in an overflow bucket, and the largest sample is kept exactly.
+ *
+ * This file does not use WPILib so it can be used on the robot and on a PC.
+ */
+class TimeHistogram
+{
+private:
+	double bucketWidth;
+	unsigned long buckets[HISTOGRAM_BUCKETS + 1];
+	unsigned long count;
+	double total;
+	double min;
+	double max;
+
+public:
+	TimeHistogram(double bucket_width);
+
+	void Clear(void);
+	void Add(double seconds);
+
+	unsigned long GetCount(void) const { return count; }
+	double GetMean(void) const { return count ? total / count : 0; }
+	double GetMin(void) const { return min; }
+	double GetMax(void) const { return max; }
+	double GetPercentile(double fraction) const;
+
+	void Print(const char *name) const;
+};
+
+#endif
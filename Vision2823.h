@@ -2,6 +2,17 @@
 #include "Vision/BinaryImage.h"
 #include "Math.h"
 #include "NetworkTables/NetworkTable.h"
+#include "VisionPipeline.h"
+#include "AllocationCounter.h"
+#ifdef VISION_LIBJPEG
+#include "JpegFrameDecoder.h"
+#include "MjpegStream.h"
+#endif
+
+//Where the camera is, and its MJPEG stream when decoding frames with libjpeg
+#define CAMERA_ADDRESS "10.28.23.11"
+#define CAMERA_PORT 80
+#define CAMERA_STREAM_PATH "/mjpg/video.mjpg"
  
 /**
  * Sample program to use NIVision to find rectangles in the scene that are illuminated
@@ -14,113 +25,159 @@
  * a minimum width of 30 pixels and maximum of 400 pixels.
  * 
  * The algorithm first does a color threshold operation that only takes objects in the
- * scene that have a bright green color component. Then a convex hull operation fills 
- * all the rectangle outlines (even the partially occluded ones). Then a small object filter
- * removes small particles that might be caused by green reflection scattered from other 
- * parts of the scene. Finally all particles are scored on rectangularity, aspect ratio,
- * and hollowness to determine if they match the target.
+ * scene that have a bright green color component. Then the ParticleLabeler finds the
+ * particles in one pass, measuring each one by its convex hull so the rectangle outlines
+ * are filled in (even the partially occluded ones), and drops small particles that might be
+ * caused by green reflection scattered from other parts of the scene. Finally all particles
+ * are scored on rectangularity, aspect ratio, and hollowness to determine if they match the target.
+ *
+ * The steps themselves live in VisionPipeline. Every buffer they use, along with the camera
+ * image, is allocated once by Start() and reused for every frame afterwards.
+ *
+ * When the robot is built with VISION_LIBJPEG (and libjpeg), an MjpegStream keeps the camera's
+ * MJPEG stream open instead, and the newest complete JPEG is decoded straight into a preallocated
+ * buffer, optionally 2 or 4 times smaller, and left in YCbCr for a YCbCrThreshold built from the
+ * pipeline's HSV threshold. No RGB or HSV image is ever made. Frames are stamped with the time
+ * they arrived rather than the time the task got to them, and any that arrive while a frame is
+ * being processed are dropped in favor of the newest.
  *
  * Look in the VisionImages directory inside the project that is created for the sample
  * images as well as the NI Vision Assistant file that contains the vision command
  * chain (open it with the Vision Assistant)
  */
 
-//Camera constants used for distance calculation
-#define X_IMAGE_RES 320		//X Image resolution in pixels, should be 160, 320 or 640
-//#define VIEW_ANGLE 48		//Axis 206 camera
-#define VIEW_ANGLE 43.5  //Axis M1011 camera
-#define PI 3.141592653
-
-//Score limits used for target identification
-#define RECTANGULARITY_LIMIT 60
-#define ASPECT_RATIO_LIMIT 75
-#define X_EDGE_LIMIT 40
-#define Y_EDGE_LIMIT 60
-
-//Minimum area of particles to be considered
-#define AREA_MINIMUM 500
-
-//Edge profile constants used for hollowness score calculation
-#define XMAXSIZE 24
-#define XMINSIZE 24
-#define YMAXSIZE 24
-#define YMINSIZE 48
-const double xMax[XMAXSIZE] = {1, 1, 1, 1, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, 1, 1, 1, 1};
-const double xMin[XMINSIZE] = {.4, .6, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, 0.6, 0};
-const double yMax[YMAXSIZE] = {1, 1, 1, 1, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, 1, 1, 1, 1};
-const double yMin[YMINSIZE] = {.4, .6, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05,
-								.05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05,
-								.05, .05, .6, 0};
-
-//Structure to represent the scores for the various tests used for target identification
-struct Scores {
-	double rectangularity;
-	double aspectRatioInner;
-	double aspectRatioOuter;
-	double xEdge;
-	double yEdge;
-
-};
-
 int start_cpp_task(UINT32 obj);
 
 class Vision2823
 {
 private:
-	Scores *scores;
 	//NetworkTable *visionScores;
-	Threshold threshold;	
-	ParticleFilterCriteria2 criteria[1];
+	VisionPipeline pipeline;
+	TargetTracker tracker;
+	bool targetTracking;
+	VisionFrame *frame;
+	ColorImage *image;
 	Task *task;
 	double delay;
 	
 	bool running;
-	bool updated;
+	VisionResultBuffer results;
+	unsigned long frameNumber;
+	unsigned long frameAllocations;
+	unsigned long maxFrameAllocations;
+#ifdef VISION_LIBJPEG
+	JpegFrameDecoder *decoder;
+	YCbCrThreshold *ycbcrThreshold;
+	MjpegStream *stream;
+	unsigned char *pixels;
+	int jpegScale;
+#endif
 	
 public:
 	void Start(void);
 	void Stop(void);
-	bool isHighGoal;
-	double highCenterXNormal;
-	double highCenterYNormal;
-	double highDistance;
-	double highDistance2;
-	int highX;
-	int highY;
-	int highWidth;
-	int highHeight;
-	
-	
-	bool isMidGoal;
-	double midCenterX;
-	double midCenterY;
-	double midDistance;
-	double midDistance2;
-	
 	int Run(void);
-	Vision2823(double in_delay) : threshold(60, 130, 90, 255, 20, 255) //HSV threshold criteria, ranges are in that order ie. Hue is 60-100
+	Vision2823(double in_delay)
 	{
-		
-		criteria[0].parameter = IMAQ_MT_AREA;
-		criteria[0].lower = AREA_MINIMUM;
-		criteria[0].upper = 65535;
-		criteria[0].calibrated = false;
-		criteria[0].exclude = false;
+		frame = NULL;
+		image = NULL;
+		targetTracking = true;
+#ifdef VISION_LIBJPEG
+		decoder = NULL;
+		ycbcrThreshold = NULL;
+		stream = NULL;
+		pixels = NULL;
+		jpegScale = 1;
+#endif
+		frameAllocations = 0;
+		maxFrameAllocations = 0;
 		//visionScores = NetworkTable::GetTable("Vision");
 		//visionScores->PutBoolean("VisionTracking", true);
 		delay = in_delay;
 		task = new Task("vision", (FUNCPTR)(&start_cpp_task));
-		updated = false;
+		frameNumber = 0;
 	};
 	
-	bool Updated(void)
+	/**
+	 * Turns on searching only around the last high goal, and sets how long the task waits
+	 * between frames. A shorter delay is affordable while a goal is being tracked.
+	 */
+	void SetTracking(bool enabled, int fullFrameInterval = FULL_FRAME_INTERVAL)
+	{
+		pipeline.SetTracking(enabled, fullFrameInterval);
+	}
+	
+	/**
+	 * Turns on following the high goal across frames with a TargetTracker, so the result holds
+	 * its smoothed position rather than the last particle scored as a goal in each frame. On
+	 * unless turned off here; call while the task is stopped.
+	 */
+	void SetTargetTracking(bool enabled)
+	{
+		targetTracking = enabled;
+		tracker.Reset();
+	}
+	
+	/**
+	 * Turns on finding candidates in a shrunken copy of each frame before searching them at full
+	 * resolution. Worth it once the camera is set to 320 or 640 wide.
+	 */
+	void SetCoarseToFine(bool enabled)
+	{
+		pipeline.SetCoarseToFine(enabled);
+	}
+	
+#ifdef VISION_LIBJPEG
+	/**
+	 * Sets how many times smaller (1, 2 or 4) the camera JPEG is decoded. Call before Start().
+	 * Smaller frames are faster but find fewer goals: of the 12 high goals in the sample images
+	 * (tools/VisionReplay), half size finds 11 and quarter size 9, since a goal only a few pixels
+	 * tall can miss the aspect ratio limit.
+	 */
+	void SetJpegScale(int scale)
+	{
+		jpegScale = scale;
+	}
+#endif
+	
+	/**
+	 * Has the pipeline work out distances with a calibration loaded from a file. Call before Start().
+	 */
+	void SetCalibration(const VisionCalibration &calibration)
+	{
+		pipeline.SetCalibration(calibration);
+	}
+	
+	/**
+	 * Sets how long the task waits between frames from AxisCamera. Reading the MJPEG stream
+	 * (VISION_LIBJPEG) the task takes each frame as it arrives and doesn't wait.
+	 */
+	void SetDelay(double in_delay)
+	{
+		delay = in_delay;
+	}
+	
+	/**
+	 * Copies out the result of the newest processed frame. This never waits on the vision task,
+	 * and a new sequence number means a new frame.
+	 */
+	void GetResult(VisionResult *result)
+	{
+		results.Read(result);
+	}
+	
+	/**
+	 * Heap allocations made during the last frame and the most made by any frame after the
+	 * first one. Both stay at 0 unless the program is built with COUNT_ALLOCATIONS.
+	 */
+	unsigned long GetFrameAllocations(void)
 	{
-		return updated;
+		return frameAllocations;
 	}
 	
-	void Clear(void)
+	unsigned long GetMaxFrameAllocations(void)
 	{
-		updated = false;
+		return maxFrameAllocations;
 	}
 };
 
@@ -0,0 +1,267 @@
+#include "VisionCalibration.h"
+#include <math.h>
+#include <string.h>
+
+/**
+ * Camera and aiming calibration. See VisionCalibration.h.
+ */
+
+#define CALIBRATION_PI 3.141592653
+
+/**
+ * Where the high goal should be for a shot, measured on the field with the camera at 320x240:
+ *
+ *   X    Y    Height  Width  Distance (feet)
+ *   147  209  25      77     26.802
+ *   145  190  34      106    19.470
+ *   165  173  39      125    16.643
+ *   171  154  46      155    13.315
+ *   161  142  51      189    10.919
+ */
+static const CalibrationPoint defaultPoints[] = {
+	{77, 209},
+	{106, 190},
+	{125, 173},
+	{155, 154},
+	{189, 142}
+};
+
+/**
+ * Starts out with the compiled in calibration.
+ */
+VisionCalibration::VisionCalibration(void)
+{
+	Set(CALIBRATION_IMAGE_WIDTH, CALIBRATION_VIEW_ANGLE, CALIBRATION_TARGET_WIDTH, CALIBRATION_HIGH_HEIGHT,
+			CALIBRATION_MID_HEIGHT, defaultPoints, sizeof(defaultPoints) / sizeof(defaultPoints[0]));
+}
+
+/**
+ * Replaces the whole calibration and works out the lookup table for it.
+ *
+ * @param in_imageWidth Width of the images the table was measured on
+ * @param in_viewAngle Degrees the camera sees across the image
+ * @param in_targetWidth Feet across the goal's tape
+ * @param in_highHeight Inches tall the high goal looks
+ * @param in_midHeight Inches tall the middle goal looks
+ * @param in_points Table of aim rows, in order of width, no two the same width
+ * @param in_pointCount Number of points, 2 to CALIBRATION_MAX_POINTS
+ * @return false, leaving the calibration as it was, if any of it doesn't make sense
+ */
+bool VisionCalibration::Set(int in_imageWidth, double in_viewAngle, double in_targetWidth, double in_highHeight,
+		double in_midHeight, const CalibrationPoint *in_points, int in_pointCount)
+{
+	if (in_imageWidth <= 0 || in_viewAngle <= 0 || in_viewAngle >= 180 || in_targetWidth <= 0
+			|| in_highHeight <= 0 || in_midHeight <= 0 || in_pointCount < 2 || in_pointCount > CALIBRATION_MAX_POINTS)
+		return false;
+	for (int i = 1; i < in_pointCount; i++)
+	{
+		if (in_points[i].width <= in_points[i - 1].width)
+			return false;
+	}
+
+	imageWidth = in_imageWidth;
+	viewAngle = in_viewAngle;
+	targetWidth = in_targetWidth;
+	highHeight = in_highHeight;
+	midHeight = in_midHeight;
+	for (int i = 0; i < in_pointCount; i++)
+		points[i] = in_points[i];
+	pointCount = in_pointCount;
+	Build();
+	return true;
+}
+
+/**
+ * Works out the camera's focal length and the aim row for every whole pixel width.
+ */
+void VisionCalibration::Build(void)
+{
+	focalScale = 1 / (2 * tan(viewAngle * CALIBRATION_PI / 360));
+
+	//Fritsch-Carlson: start from the average of the slopes on each side of a point, flatten it
+	//where the table turns round, then scale both ends of any segment where they are steep
+	//enough to make the cubic overshoot
+	int n = pointCount;
+	if (n < 2)
+	{
+		//Set() doesn't allow this, but a single point can only mean the same row at every width
+		for (int i = 0; i < CALIBRATION_TABLE_SIZE; i++)
+			aimTable[i] = n == 1 ? points[0].aimY : 0;
+		return;
+	}
+	double slopes[CALIBRATION_MAX_POINTS];
+	double tangents[CALIBRATION_MAX_POINTS];
+	for (int i = 0; i < n - 1; i++)
+		slopes[i] = (points[i + 1].aimY - points[i].aimY) / (points[i + 1].width - points[i].width);
+	tangents[0] = slopes[0];
+	tangents[n - 1] = slopes[n - 2];
+	for (int i = 1; i < n - 1; i++)
+		tangents[i] = slopes[i - 1] * slopes[i] > 0 ? (slopes[i - 1] + slopes[i]) / 2 : 0;
+	for (int i = 0; i < n - 1; i++)
+	{
+		if (slopes[i] == 0)
+		{
+			tangents[i] = 0;
+			tangents[i + 1] = 0;
+			continue;
+		}
+		double a = tangents[i] / slopes[i];
+		double b = tangents[i + 1] / slopes[i];
+		double length = a * a + b * b;
+		if (length > 9)
+		{
+			double t = 3 / sqrt(length);
+			tangents[i] = t * a * slopes[i];
+			tangents[i + 1] = t * b * slopes[i];
+		}
+	}
+
+	int segment = 0;
+	for (int i = 0; i < CALIBRATION_TABLE_SIZE; i++)
+	{
+		double x = i;
+		if (x <= points[0].width)
+		{
+			aimTable[i] = points[0].aimY + tangents[0] * (x - points[0].width);
+			continue;
+		}
+		if (x >= points[n - 1].width)
+		{
+			aimTable[i] = points[n - 1].aimY + tangents[n - 1] * (x - points[n - 1].width);
+			continue;
+		}
+		while (x > points[segment + 1].width)
+			segment++;
+		const CalibrationPoint *p0 = &points[segment];
+		const CalibrationPoint *p1 = &points[segment + 1];
+		double h = p1->width - p0->width;
+		double t = (x - p0->width) / h;
+		double t2 = t * t;
+		double t3 = t2 * t;
+		aimTable[i] = (2 * t3 - 3 * t2 + 1) * p0->aimY + (t3 - 2 * t2 + t) * h * tangents[segment]
+				+ (-2 * t3 + 3 * t2) * p1->aimY + (t3 - t2) * h * tangents[segment + 1];
+	}
+}
+
+/**
+ * Reads a calibration file (see VisionCalibration.h).
+ *
+ * @return false, leaving the calibration as it was, if the file can't be read or doesn't make sense
+ */
+bool VisionCalibration::Load(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		printf("VisionCalibration: can't open %s, keeping the built in calibration\n", path);
+		return false;
+	}
+	int newImageWidth = imageWidth;
+	double newViewAngle = viewAngle;
+	double newTargetWidth = targetWidth;
+	double newHighHeight = highHeight;
+	double newMidHeight = midHeight;
+	CalibrationPoint newPoints[CALIBRATION_MAX_POINTS];
+	int newPointCount = 0;
+	char line[256];
+	int lineNumber = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), file))
+	{
+		lineNumber++;
+		char key[32] = "";
+		char *p = line;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0)
+			continue;
+		if (sscanf(p, "%31s", key) != 1)
+			ok = false;
+		else if (strcmp(key, "image_width") == 0)
+			ok = sscanf(p, "%*s %d", &newImageWidth) == 1;
+		else if (strcmp(key, "view_angle") == 0)
+			ok = sscanf(p, "%*s %lf", &newViewAngle) == 1;
+		else if (strcmp(key, "target_width") == 0)
+			ok = sscanf(p, "%*s %lf", &newTargetWidth) == 1;
+		else if (strcmp(key, "high_height") == 0)
+			ok = sscanf(p, "%*s %lf", &newHighHeight) == 1;
+		else if (strcmp(key, "mid_height") == 0)
+			ok = sscanf(p, "%*s %lf", &newMidHeight) == 1;
+		else if (strcmp(key, "point") == 0)
+		{
+			if (newPointCount == CALIBRATION_MAX_POINTS)
+			{
+				printf("VisionCalibration: %s:%d: more than %d points\n", path, lineNumber, CALIBRATION_MAX_POINTS);
+				ok = false;
+				break;
+			}
+			CalibrationPoint *point = &newPoints[newPointCount++];
+			ok = sscanf(p, "%*s %lf %lf", &point->width, &point->aimY) == 2;
+		}
+		else
+			ok = false;
+		if (!ok)
+			printf("VisionCalibration: %s:%d: can't read \"%s\"\n", path, lineNumber, key);
+	}
+	fclose(file);
+	if (!ok)
+		return false;
+	if (!Set(newImageWidth, newViewAngle, newTargetWidth, newHighHeight, newMidHeight, newPoints, newPointCount))
+	{
+		printf("VisionCalibration: %s: settings out of range, or points not in order of width\n", path);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Writes the calibration in the form Load() reads.
+ */
+void VisionCalibration::Write(FILE *file) const
+{
+	fprintf(file, "image_width %d\n", imageWidth);
+	fprintf(file, "view_angle %.3f\n", viewAngle);
+	fprintf(file, "target_width %.4f\n", targetWidth);
+	fprintf(file, "high_height %.3f\n", highHeight);
+	fprintf(file, "mid_height %.3f\n", midHeight);
+	fprintf(file, "# width, image row to aim the high goal at\n");
+	for (int i = 0; i < pointCount; i++)
+		fprintf(file, "point %.2f %.2f\n", points[i].width, points[i].aimY);
+}
+
+/**
+ * The image row the high goal should be at for a shot, given how wide it is.
+ *
+ * @param width Width of the high goal in pixels
+ * @param in_imageWidth Width of the image it was seen in
+ */
+double VisionCalibration::GetAimY(double width, int in_imageWidth) const
+{
+	double scale = (double) imageWidth / in_imageWidth;
+	double x = width * scale;
+	if (x <= 0)
+		return aimTable[0] / scale;
+	if (x >= CALIBRATION_TABLE_SIZE - 1)
+		return aimTable[CALIBRATION_TABLE_SIZE - 1] / scale;
+	int i = (int) x;
+	double f = x - i;
+	return (aimTable[i] + f * (aimTable[i + 1] - aimTable[i])) / scale;
+}
+
+/**
+ * Distance to a goal in feet, from its width in pixels.
+ */
+double VisionCalibration::GetDistanceFromWidth(double width, int in_imageWidth) const
+{
+	return in_imageWidth * focalScale * targetWidth / width;
+}
+
+/**
+ * Distance to a goal in feet, from its height in pixels.
+ *
+ * @param mid True for the middle goal, false for the high goal
+ */
+double VisionCalibration::GetDistanceFromHeight(double height, int in_imageWidth, bool mid) const
+{
+	return in_imageWidth * focalScale * (mid ? midHeight : highHeight) / (12 * height);
+}
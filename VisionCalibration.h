@@ -0,0 +1,90 @@
+#ifndef VISIONCALIBRATION_H
+#define VISIONCALIBRATION_H
+
+#include <stdio.h>
+
+//Compiled in calibration, used until a file is loaded
+#define CALIBRATION_IMAGE_WIDTH 320		//image width the table and target sizes were measured at
+#define CALIBRATION_VIEW_ANGLE 43.5		//Axis M1011 camera (the Axis 206 is 48), degrees across the image
+#define CALIBRATION_TARGET_WIDTH 5.146	//feet across the high goal's tape, for the distance from its width
+#define CALIBRATION_HIGH_HEIGHT 21		//inches tall the high goal looks, for the distance from its height
+#define CALIBRATION_MID_HEIGHT 29		//and the middle goal
+
+//Most points a calibration table may have, and the widths its lookup table covers (0 to 640)
+#define CALIBRATION_MAX_POINTS 32
+#define CALIBRATION_TABLE_SIZE 641
+
+/**
+ * One row of the calibration table: a high goal this many pixels wide should be at this image
+ * row for the shot to go in.
+ */
+struct CalibrationPoint {
+	double width;
+	double aimY;
+};
+
+/**
+ * What the vision code needs to know about the camera and the field, kept in one place so
+ * recalibrating means loading a new file rather than editing constants and polynomials.
+ *
+ * The camera's view angle and the goal sizes turn a goal's width or height in pixels into a
+ * distance. The table gives the image row the high goal should be at for a shot, by the goal's
+ * width. Between the table's points the row follows a monotone cubic (Fritsch-Carlson), which
+ * goes through every point without overshooting between them, so a table that only ever falls
+ * as the goal gets wider gives rows that only ever fall too. Past the first and last points
+ * the row carries on in a straight line. The curve is worked out once for every whole pixel
+ * width when the table is set, so a lookup is one linear interpolation.
+ *
+ * A calibration file is plain text, one setting per line, with # starting a comment:
+ *
+ *   image_width 320
+ *   view_angle 43.5
+ *   target_width 5.146
+ *   high_height 21
+ *   mid_height 29
+ *   point <width> <aim row>
+ *
+ * with a point line for each row of the table, at least two. Settings that are left out keep
+ * their compiled in values. tools/CalibrationFit writes these files from measured samples.
+ *
+ * Widths and rows given to the lookups are in pixels of an image in_imageWidth wide, and are
+ * scaled to and from the calibration's image width. This file does not use WPILib.
+ */
+class VisionCalibration
+{
+private:
+	int imageWidth;
+	double viewAngle;
+	double targetWidth;
+	double highHeight;
+	double midHeight;
+	CalibrationPoint points[CALIBRATION_MAX_POINTS];
+	int pointCount;
+
+	double focalScale;		//distance to the image plane in image widths, 1 / (2 tan(viewAngle / 2))
+	double aimTable[CALIBRATION_TABLE_SIZE];
+
+	void Build(void);
+
+public:
+	VisionCalibration(void);
+
+	bool Set(int in_imageWidth, double in_viewAngle, double in_targetWidth, double in_highHeight,
+			double in_midHeight, const CalibrationPoint *in_points, int in_pointCount);
+	bool Load(const char *path);
+	void Write(FILE *file) const;
+
+	double GetAimY(double width, int in_imageWidth) const;
+	double GetDistanceFromWidth(double width, int in_imageWidth) const;
+	double GetDistanceFromHeight(double height, int in_imageWidth, bool mid) const;
+
+	int GetImageWidth(void) const { return imageWidth; }
+	double GetViewAngle(void) const { return viewAngle; }
+	double GetTargetWidth(void) const { return targetWidth; }
+	double GetHighHeight(void) const { return highHeight; }
+	double GetMidHeight(void) const { return midHeight; }
+	int GetPointCount(void) const { return pointCount; }
+	const CalibrationPoint *GetPoint(int i) const { return &points[i]; }
+};
+
+#endif
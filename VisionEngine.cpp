@@ -0,0 +1,349 @@
+#include "VisionEngine.h"
+#include <sched.h>
+
+/**
+ * Threads and queues that run VisionPipeline on several frames at once. See VisionEngine.h.
+ */
+
+VisionEngineSlot::VisionEngineSlot(void)
+{
+	pixels = new unsigned char[MAX_IMAGE_WIDTH * MAX_IMAGE_HEIGHT * 4];
+	pixelStride = MAX_IMAGE_WIDTH * 4;
+	width = 0;
+	height = 0;
+	data = NULL;
+	decoded = false;
+	dropped = false;
+}
+
+VisionEngineSlot::~VisionEngineSlot()
+{
+	delete [] pixels;
+}
+
+//what each worker thread is started with
+struct VisionWorker {
+	VisionEngine *engine;
+	int index;
+};
+
+/**
+ * @param in_source Where the images come from
+ * @param worker_count Number of threads decoding and processing frames
+ * @param drop_policy What to do with frames that fall behind
+ * @param slots_per_worker Frames in flight for each worker, on top of the one being captured
+ */
+VisionEngine::VisionEngine(VisionSource *in_source, int worker_count, VisionDropPolicy drop_policy, int slots_per_worker) :
+	source(in_source),
+	policy(drop_policy),
+	workerCount(worker_count < 1 ? 1 : worker_count),
+	slotCount(workerCount * (slots_per_worker < 1 ? 1 : slots_per_worker) + 1),
+	freeQueue(slotCount),
+	decodeQueue(slotCount),
+	processQueue(slotCount),
+	doneQueue(slotCount)
+{
+	slots = new VisionEngineSlot[slotCount];
+	pipelines = new VisionPipeline[workerCount];
+	pending = new VisionEngineSlot *[slotCount];
+	workerThreads = new pthread_t[workerCount];
+	workers = new VisionWorker[workerCount];
+	for (int i = 0; i < slotCount; i++)
+	{
+		pending[i] = NULL;
+		freeQueue.TryPush(&slots[i]);
+	}
+	sem_init(&freeReady, 0, slotCount);
+	sem_init(&workReady, 0, 0);
+	sem_init(&doneReady, 0, 0);
+	sem_init(&finished, 0, 0);
+	running = false;
+	started = false;
+	stopped = false;
+	workersStarted = 0;
+	targetTracking = false;
+	captured = 0;
+	published = 0;
+	dropped = 0;
+}
+
+VisionEngine::~VisionEngine()
+{
+	Stop();
+	sem_destroy(&freeReady);
+	sem_destroy(&workReady);
+	sem_destroy(&doneReady);
+	sem_destroy(&finished);
+	delete [] workerThreads;
+	delete [] workers;
+	delete [] pending;
+	delete [] pipelines;
+	delete [] slots;
+}
+
+/**
+ * Turns on tracking in every worker's pipeline. Only call this while the engine is stopped.
+ */
+void VisionEngine::SetTracking(bool enabled, int full_frame_interval)
+{
+	for (int i = 0; i < workerCount; i++)
+		pipelines[i].SetTracking(enabled, full_frame_interval);
+}
+
+/**
+ * Turns on coarse to fine search in every worker's pipeline. Only call this while the engine
+ * is stopped.
+ */
+void VisionEngine::SetCoarseToFine(bool enabled)
+{
+	for (int i = 0; i < workerCount; i++)
+		pipelines[i].SetCoarseToFine(enabled);
+}
+
+/**
+ * Has every worker's pipeline work out distances with the given calibration. Only call this
+ * while the engine is stopped.
+ */
+void VisionEngine::SetCalibration(const VisionCalibration &calibration)
+{
+	for (int i = 0; i < workerCount; i++)
+		pipelines[i].SetCalibration(calibration);
+}
+
+/**
+ * Turns on following the high goal across published frames with a TargetTracker. Only call
+ * this while the engine is stopped.
+ */
+void VisionEngine::SetTargetTracking(bool enabled)
+{
+	targetTracking = enabled;
+	tracker.Reset();
+}
+
+/**
+ * Has every worker's pipeline threshold YCbCr pixels with a shared table. Only call this while
+ * the engine is stopped.
+ */
+void VisionEngine::SetYCbCrThreshold(const YCbCrThreshold *table)
+{
+	for (int i = 0; i < workerCount; i++)
+		pipelines[i].SetYCbCrThreshold(table);
+}
+
+/**
+ * Starts the capture, worker and publishing threads. An engine only runs once: the queues and
+ * counts are left part way through a frame when it is stopped, so it can't be started again
+ * after Stop(), or after a Start() that failed. Make a new one instead.
+ *
+ * @return False if the threads could not be started, or the engine has already been stopped
+ */
+bool VisionEngine::Start(void)
+{
+	if (started)
+		return true;
+	if (stopped)
+		return false;
+	running = true;
+	workersStarted = 0;
+	bool ok = pthread_create(&captureThread, NULL, RunCapture, this) == 0;
+	if (ok && pthread_create(&publishThread, NULL, RunPublish, this) != 0)
+	{
+		ok = false;
+		running = false;
+		sem_post(&freeReady);
+		pthread_join(captureThread, NULL);
+	}
+	for (; ok && workersStarted < workerCount; workersStarted++)
+	{
+		workers[workersStarted].engine = this;
+		workers[workersStarted].index = workersStarted;
+		if (pthread_create(&workerThreads[workersStarted], NULL, RunWorker, &workers[workersStarted]) != 0)
+			break;
+	}
+	started = ok;
+	stopped = !ok;
+	if (ok && workersStarted < workerCount)
+	{
+		Stop();
+		return false;
+	}
+	return ok;
+}
+
+/**
+ * Stops every thread that was started, abandoning any frames still in flight.
+ */
+void VisionEngine::Stop(void)
+{
+	if (!started)
+		return;
+	running = false;
+	for (int i = 0; i < slotCount; i++)
+		sem_post(&freeReady);
+	for (int i = 0; i < workersStarted; i++)
+		sem_post(&workReady);
+	sem_post(&doneReady);
+	pthread_join(captureThread, NULL);
+	for (int i = 0; i < workersStarted; i++)
+		pthread_join(workerThreads[i], NULL);
+	pthread_join(publishThread, NULL);
+	workersStarted = 0;
+	started = false;
+	stopped = true;
+}
+
+/**
+ * Waits until the source has run out of images and every frame captured from it has been
+ * published or dropped.
+ */
+void VisionEngine::WaitUntilDone(void)
+{
+	if (started)
+		sem_wait(&finished);
+}
+
+/**
+ * Pops from a queue that is known to have an item in it.
+ */
+VisionEngineSlot *VisionEngine::Take(BoundedQueue<VisionEngineSlot *> *queue)
+{
+	VisionEngineSlot *slot;
+	while (!queue->TryPop(&slot))
+		sched_yield();
+	return slot;
+}
+
+void *VisionEngine::RunCapture(void *engine)
+{
+	VisionEngine *e = (VisionEngine *) engine;
+	unsigned long sequence = 0;
+
+	while (e->running)
+	{
+		sem_wait(&e->freeReady);
+		if (!e->running)
+			break;
+		VisionEngineSlot *slot = Take(&e->freeQueue);
+		slot->decoded = false;
+		slot->dropped = false;
+		if (!e->source->Capture(slot))
+		{
+			e->freeQueue.TryPush(slot);
+			sem_post(&e->freeReady);
+			break;
+		}
+		slot->frame.result.sequence = ++sequence;
+		e->captured = sequence;
+		e->decodeQueue.TryPush(slot);
+		sem_post(&e->workReady);
+	}
+
+	//every slot comes back to the free queue once the frames in flight are done with
+	for (int i = 0; i < e->slotCount && e->running; i++)
+		sem_wait(&e->freeReady);
+	sem_post(&e->finished);
+	return NULL;
+}
+
+void *VisionEngine::RunWorker(void *worker)
+{
+	VisionWorker *w = (VisionWorker *) worker;
+	w->engine->Work(w->index);
+	return NULL;
+}
+
+/**
+ * Worker thread loop. Frames that are already decoded come first, so the oldest frames are
+ * finished before new ones are started.
+ */
+void VisionEngine::Work(int worker)
+{
+	VisionPipeline *pipeline = &pipelines[worker];
+
+	for (;;)
+	{
+		sem_wait(&workReady);
+		if (!running)
+			break;
+		VisionEngineSlot *slot;
+		while (!processQueue.TryPop(&slot) && !decodeQueue.TryPop(&slot))
+			sched_yield();
+
+		if (slot->decoded)
+		{
+			pipeline->Process(&slot->frame, slot->pixels, slot->pixelStride, slot->width, slot->height);
+		}
+		else if ((policy == VISION_DROP_STALE && captured - slot->frame.result.sequence >= (unsigned long) workerCount)
+				|| !source->Decode(slot))
+		{
+			slot->dropped = true;
+		}
+		else
+		{
+			slot->decoded = true;
+			processQueue.TryPush(slot);
+			sem_post(&workReady);
+			continue;
+		}
+		doneQueue.TryPush(slot);
+		sem_post(&doneReady);
+	}
+}
+
+void *VisionEngine::RunPublish(void *engine)
+{
+	VisionEngine *e = (VisionEngine *) engine;
+	unsigned long next = 1;
+	unsigned long lastSequence = 0;
+
+	for (;;)
+	{
+		sem_wait(&e->doneReady);
+		if (!e->running)
+			break;
+		VisionEngineSlot *slot = Take(&e->doneQueue);
+		if (e->policy != VISION_KEEP_ALL)
+		{
+			e->Publish(slot, &lastSequence);
+			continue;
+		}
+
+		//hold on to frames that finished early until the ones captured before them are done
+		e->pending[slot->frame.result.sequence % e->slotCount] = slot;
+		while ((slot = e->pending[next % e->slotCount]) != NULL && slot->frame.result.sequence == next)
+		{
+			e->pending[next % e->slotCount] = NULL;
+			e->Publish(slot, &lastSequence);
+			next++;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Publishes a finished frame unless it was dropped or is older than the last one published,
+ * then gives its slot back to the capture thread.
+ */
+void VisionEngine::Publish(VisionEngineSlot *slot, unsigned long *lastSequence)
+{
+	if (!slot->dropped && slot->frame.result.sequence > *lastSequence)
+	{
+		if (targetTracking)
+		{
+			VisionFrame *frame = &slot->frame;
+			tracker.Update(frame->highDetections, frame->highDetectionCount, frame->result.timestamp);
+			tracker.Report(&frame->result, frame->width, frame->height);
+		}
+		results.Publish(slot->frame.result);
+		*lastSequence = slot->frame.result.sequence;
+		published++;
+	}
+	else
+	{
+		slot->dropped = true;
+		dropped++;
+	}
+	source->Finished(slot);
+	freeQueue.TryPush(slot);
+	sem_post(&freeReady);
+}
@@ -0,0 +1,166 @@
+#ifndef VISIONENGINE_H
+#define VISIONENGINE_H
+
+#include "VisionPipeline.h"
+#include "BoundedQueue.h"
+#include <pthread.h>
+#include <semaphore.h>
+
+//Default number of worker threads, and frames in flight for each worker
+#define VISION_WORKERS 2
+#define VISION_SLOTS_PER_WORKER 2
+
+/**
+ * What the engine does with frames that fall behind.
+ *
+ * VISION_KEEP_ALL processes every captured frame and publishes them all in capture order, which
+ * is what a replay or benchmark wants.
+ *
+ * VISION_DROP_STALE keeps the results as fresh as possible. A frame is dropped without being
+ * decoded if at least as many newer frames have been captured as there are workers, since those
+ * newer frames are enough to keep every worker busy. A finished frame is also dropped if a newer
+ * one has already been published, so the result never goes backwards.
+ */
+enum VisionDropPolicy {
+	VISION_KEEP_ALL,
+	VISION_DROP_STALE
+};
+
+/**
+ * One frame in flight through the engine, along with the image it came from. All of it is
+ * allocated by the engine up front and reused.
+ */
+class VisionEngineSlot
+{
+public:
+	VisionFrame frame;
+	unsigned char *pixels;		//MAX_IMAGE_WIDTH by MAX_IMAGE_HEIGHT, 4 bytes per pixel, for Decode() to fill
+	int pixelStride;
+	int width;
+	int height;
+	void *data;					//whatever the source needs to remember between Capture() and Decode()
+	bool decoded;
+	bool dropped;
+
+	VisionEngineSlot(void);
+	~VisionEngineSlot();
+};
+
+/**
+ * Where the engine gets its images from.
+ *
+ * Capture() grabs the next image into a slot, as cheaply as it can, and stamps
+ * frame.result.timestamp. It is only ever called from the capture thread, one slot at a time.
+ * Returning false stops the capture.
+ *
+ * Decode() turns what Capture() grabbed into pixels. It is called from the worker threads, on
+ * several slots at once. Returning false drops the frame.
+ *
+ * Finished() is called from the publishing thread for every captured frame once it has been
+ * published or dropped, just before the slot is reused.
+ */
+class VisionSource
+{
+public:
+	virtual ~VisionSource() {}
+	virtual bool Capture(VisionEngineSlot *slot) = 0;
+	virtual bool Decode(VisionEngineSlot *slot) = 0;
+	virtual void Finished(VisionEngineSlot *slot) { (void) slot; }
+};
+
+struct VisionWorker;
+
+/**
+ * Runs the vision pipeline as a set of stages that overlap from one frame to the next, so
+ * throughput grows with the number of processor cores instead of being capped by the time one
+ * frame takes from capture to score.
+ *
+ * One thread captures, a pool of workers decodes and processes, and one thread publishes:
+ *
+ *   capture --> decode queue --> workers (decode, then threshold/label/score) --> done queue --> publish
+ *                                  ^------------------- process queue ----------------|
+ *
+ * The queues are BoundedQueues with a counting semaphore alongside to put idle threads to sleep.
+ * A decoded frame goes on the process queue, which workers check before the decode queue, so
+ * older frames are finished before newer ones are started and frame N+1 can decode while frame
+ * N is scored. The publishing thread puts results in order (or drops them, see
+ * VisionDropPolicy), publishes them and hands the slots back to the capture thread.
+ *
+ * Each worker has its own VisionPipeline, so with tracking turned on a worker tracks the goal
+ * across the frames it processes rather than every frame.
+ *
+ * With target tracking turned on, the publishing thread runs a TargetTracker over the frames it
+ * publishes, which are in capture order whatever order the workers finish them in.
+ *
+ * An engine is started and stopped once; to run again after Stop(), make a new one.
+ *
+ * This file does not use WPILib. The threads are POSIX threads, which the cRIO also provides,
+ * but it only has one core, so Vision2823 still runs the pipeline on its own task there.
+ */
+class VisionEngine
+{
+private:
+	VisionSource *source;
+	VisionDropPolicy policy;
+	int workerCount;
+	int slotCount;
+	VisionEngineSlot *slots;
+	VisionPipeline *pipelines;
+	TargetTracker tracker;			//run by the publishing thread, on frames in capture order
+	bool targetTracking;
+
+	BoundedQueue<VisionEngineSlot *> freeQueue, decodeQueue, processQueue, doneQueue;
+	sem_t freeReady, workReady, doneReady, finished;
+	VisionEngineSlot **pending;		//finished slots waiting for their turn to be published, by sequence
+
+	pthread_t captureThread, publishThread;
+	pthread_t *workerThreads;
+	VisionWorker *workers;
+	int workersStarted;				//worker threads Start() got going, which Stop() joins
+	volatile bool running;
+	bool started;
+	bool stopped;					//Start() can't be called again once this is set
+
+	volatile unsigned long captured;
+	volatile unsigned long published, dropped;
+	VisionResultBuffer results;
+
+	static void *RunCapture(void *engine);
+	static void *RunWorker(void *worker);
+	static void *RunPublish(void *engine);
+	static VisionEngineSlot *Take(BoundedQueue<VisionEngineSlot *> *queue);
+	void Work(int worker);
+	void Publish(VisionEngineSlot *slot, unsigned long *lastSequence);
+
+public:
+	VisionEngine(VisionSource *in_source, int worker_count = VISION_WORKERS, VisionDropPolicy drop_policy = VISION_DROP_STALE,
+			int slots_per_worker = VISION_SLOTS_PER_WORKER);
+	~VisionEngine();
+
+	void SetTracking(bool enabled, int full_frame_interval = FULL_FRAME_INTERVAL);
+	void SetCoarseToFine(bool enabled);
+	void SetYCbCrThreshold(const YCbCrThreshold *table);
+	void SetTargetTracking(bool enabled);
+	void SetCalibration(const VisionCalibration &calibration);
+
+	bool Start(void);
+	void Stop(void);
+	void WaitUntilDone(void);
+
+	/**
+	 * Copies out the result of the newest published frame. This never waits on the engine.
+	 */
+	void GetResult(VisionResult *result) const
+	{
+		results.Read(result);
+	}
+
+	unsigned long GetCapturedCount(void) const { return captured; }
+	unsigned long GetPublishedCount(void) const { return published; }
+	unsigned long GetDroppedCount(void) const { return dropped; }
+	int GetWorkerCount(void) const { return workerCount; }
+	int GetSlotCount(void) const { return slotCount; }
+	VisionEngineSlot *GetSlot(int i) { return &slots[i]; }
+};
+
+#endif
@@ -0,0 +1,540 @@
+#include "VisionPipeline.h"
+#include <math.h>
+/**
+ * Image processing code to identify 2013 Vision targets
+ */
+
+/**
+ * Computes the estimated distance to a target using the height of the particle in the image. For more information and graphics
+ * showing the math behind this approach see the Vision Processing section of the ScreenStepsLive documentation.
+ * 
+ * @param report The report for the particle, including the equivalent rectangle measured by the labeler
+ * @param outer True if the particle should be treated as an outer target, false to treat it as a center target
+ * @param calibration The camera's view angle and the target sizes
+ * @return The estimated distance to the target in feet.
+ */
+double computeDistance (ParticleReport *report, bool outer, const VisionCalibration &calibration) {
+	double height;
+	
+	//using the smaller of the estimated rectangle short side and the bounding rectangle height results in better performance
+	//on skewed rectangles
+	height = report->boundingRect.height < report->equivalentRectShort ? report->boundingRect.height : report->equivalentRectShort;
+	
+	return calibration.GetDistanceFromHeight(height, report->imageWidth, outer);
+}
+
+
+/**
+ * Computes the estimated distance to a target in feet using the width of the particle in the image.
+ */
+double computeDistance2 (ParticleReport *report, const VisionCalibration &calibration)
+{	
+	return calibration.GetDistanceFromWidth(report->boundingRect.width, report->imageWidth);
+}
+
+
+
+/**
+ * Measures the aspect ratio of a particle, the one thing the aspect ratio scores of every kind of
+ * target need. This uses the equivalent rectangle sides as it performs better as the target gets
+ * skewed by moving to the left or right. The equivalent rectangle is the rectangle with sides x and y
+ * where particle area= x*y and particle perimeter= 2x+2y
+ * 
+ * @param report The report for the particle, used for the width, height, and equivalent rectangle sides
+ * @return Width over height of the equivalent rectangle
+ */
+double measureAspectRatio(ParticleReport *report){
+	double rectLong = report->equivalentRectLong;
+	double rectShort = report->equivalentRectShort;
+	
+	//Divide width by height to measure aspect ratio
+	if(report->boundingRect.width > report->boundingRect.height){
+		//particle is wider than it is tall, divide long by short
+		return rectLong/rectShort;
+	} else {
+		//particle is taller than it is wide, divide short by long
+		return rectShort/rectLong;
+	}
+}
+
+/**
+ * Computes a score (0-100) comparing a measured aspect ratio to the ideal aspect ratio for a target.
+ * 
+ * @param aspectRatio The particle's aspect ratio from measureAspectRatio()
+ * @param target What the target should look like
+ * @return The aspect ratio score (0-100)
+ */
+double scoreAspectRatio(double aspectRatio, const TargetDescriptor &target){
+	double score = 100*(1-fabs((1-(aspectRatio/target.aspectRatio))));
+	//force to be in range 0-100
+	if (score < 0)
+		return 0;
+	if (score > 100)
+		return 100;
+	return score;
+}
+
+/**
+ * Compares scores to a target's limits and returns true if the particle appears to be that target
+ * 
+ * @param scores The structure containing the scores to compare
+ * @param type Which of targetDescriptors to compare them with
+ * 
+ * @return True if the particle meets all limits, false otherwise
+ */
+bool scoreCompare(const Scores &scores, int type){
+	const TargetDescriptor &target = targetDescriptors[type];
+	return scores.rectangularity > target.rectangularityLimit
+			&& scores.aspectRatio[type] > target.aspectRatioLimit
+			&& scores.xEdge > target.xEdgeLimit
+			&& scores.yEdge > target.yEdgeLimit;
+}
+
+/**
+ * Computes a score (0-100) estimating how rectangular the particle is by comparing the area of the particle
+ * to the area of the bounding box surrounding it. A perfect rectangle would cover the entire bounding box.
+ * 
+ * @param report The Particle Analysis Report for the particle to score
+ * @return The rectangularity score (0-100)
+ */
+double scoreRectangularity(ParticleReport *report){
+	if(report->boundingRect.width*report->boundingRect.height !=0){
+		return 100*report->particleArea/(report->boundingRect.width*report->boundingRect.height);
+	} else {
+		return 0;
+	}	
+}
+
+/**
+ * Counts how many entries of a profile fall between the template limits. Entry i is compared to
+ * minimum[i*(minSize-1)/count] and maximum[i*(maxSize-1)/count], with the indexes stepped along
+ * without dividing.
+ * 
+ * @param counts Set pixels in each row or column of the particle
+ * @param count Number of rows or columns
+ * @param across Length of each row or column, to turn the counts into averages
+ * @param slack Pixels an entry may be outside the limits by and still count
+ * @return The number of entries inside the limits
+ */
+int edgeMatches(const unsigned short *counts, int count, int across,
+		const double *minimum, int minSize, const double *maximum, int maxSize, double slack){
+	int matches = 0;
+	int minIndex = 0, minRemainder = 0;
+	int maxIndex = 0, maxRemainder = 0;
+	double scale = 1.0 / across;
+	slack *= scale;
+	
+	for(int i=0; i < count; i++){
+		double average = counts[i] * scale;
+		if(minimum[minIndex] - slack < average && average < maximum[maxIndex] + slack){
+			matches++;
+		}
+		for(minRemainder += minSize - 1; minRemainder >= count; minRemainder -= count){
+			minIndex++;
+		}
+		for(maxRemainder += maxSize - 1; maxRemainder >= count; maxRemainder -= count){
+			maxIndex++;
+		}
+	}
+	return matches;
+}
+
+/**
+ * Computes a score based on the match between a template profile and the particle profile in the X direction. This method uses the
+ * the column averages and the profile defined at the top of the sample to look for the solid vertical edges with
+ * a hollow center.
+ * 
+ * @param report The report for the particle, with the column counts taken before the convex hull fills it in
+ * @param slack Pixels each column may be off from the profile, see edgeSlack()
+ * 
+ * @return The X Edge Score (0-100)
+ */
+double scoreXEdge(ParticleReport *report, double slack){
+	int columnCount = report->boundingRect.width;
+	int total = edgeMatches(report->columnCounts, columnCount, report->boundingRect.height, xMin, XMINSIZE, xMax, XMAXSIZE, slack);
+	return 100.0*total/columnCount;		//convert to score 0-100
+}
+
+/**
+ * Computes a score based on the match between a template profile and the particle profile in the Y direction. This method uses the
+ * the row averages and the profile defined at the top of the sample to look for the solid horizontal edges with
+ * a hollow center
+ * 
+ * @param report The report for the particle, with the row counts taken before the convex hull fills it in
+ * @param slack Pixels each row may be off from the profile, see edgeSlack()
+ * 
+ * @return The Y Edge score (0-100)
+ */
+double scoreYEdge(ParticleReport *report, double slack){
+	int rowCount = report->boundingRect.height;
+	int total = edgeMatches(report->rowCounts, rowCount, report->boundingRect.width, yMin, YMINSIZE, yMax, YMAXSIZE, slack);
+	return 100.0*total/rowCount;		//convert to score 0-100
+}
+
+/**
+ * Scales a length in pixels tuned at X_IMAGE_RES to an image of another width.
+ */
+static int scaleToWidth(int pixels, int width){
+	return pixels * width / X_IMAGE_RES;
+}
+
+/**
+ * The smallest particle area to keep in an image of the given width, AREA_MINIMUM being the
+ * area at X_IMAGE_RES.
+ */
+static double areaMinimum(int width){
+	double scale = (double) width / X_IMAGE_RES;
+	return AREA_MINIMUM * scale * scale;
+}
+
+/**
+ * Pixels each row or column of a particle may be off from the edge profiles in an image of the
+ * given width. The profiles were tuned at X_IMAGE_RES, where the tape is several pixels thick;
+ * shrinking the image blends the tape's edges with the background, so every X_IMAGE_RES pixel
+ * merged into one can leave a row or column a pixel fuller or emptier than the profile allows.
+ */
+static double edgeSlack(int width){
+	return width < X_IMAGE_RES ? (double) X_IMAGE_RES / width - 1 : 0;
+}
+
+VisionFrame::VisionFrame(void) : labeler(MAX_IMAGE_WIDTH, MAX_IMAGE_HEIGHT, MAX_RUNS, MAX_PARTICLES)
+{
+	width = 0;
+	height = 0;
+	maskStride = MAX_IMAGE_WIDTH;
+	mask = new unsigned char[MAX_IMAGE_WIDTH * MAX_IMAGE_HEIGHT];
+	coarsePixels = new unsigned char[(MAX_IMAGE_WIDTH / 2) * (MAX_IMAGE_HEIGHT / 2) * 4];
+	coarseMask = new unsigned char[(MAX_IMAGE_WIDTH / 2) * (MAX_IMAGE_HEIGHT / 2)];
+	searchAreaCount = 0;
+	particleCount = 0;
+	highDetectionCount = 0;
+	result.sequence = 0;
+	result.timestamp = 0;
+	result.tracked = false;
+	result.imageWidth = 0;
+	result.imageHeight = 0;
+	result.isHighGoal = false;
+	result.highTrackId = 0;
+	result.isMidGoal = false;
+}
+
+VisionFrame::~VisionFrame()
+{
+	delete [] mask;
+	delete [] coarsePixels;
+	delete [] coarseMask;
+}
+
+/**
+ * Thresholds a camera image into the frame's mask to get just the green target pixels.
+ * 
+ * @param frame The frame to fill in
+ * @param pixels First pixel of the camera image, laid out like an IMAQ RGB image (or Y, Cb, Cr
+ *               and an unused byte if a YCbCrThreshold has been set)
+ * @param pixelStride Bytes from the start of one image row to the next
+ * @param width Width of the image, no more than MAX_IMAGE_WIDTH
+ * @param height Height of the image, no more than MAX_IMAGE_HEIGHT
+ */
+void VisionPipeline::Threshold(VisionFrame *frame, const unsigned char *pixels, int pixelStride, int width, int height)
+{
+	if (width > MAX_IMAGE_WIDTH)
+		width = MAX_IMAGE_WIDTH;
+	if (height > MAX_IMAGE_HEIGHT)
+		height = MAX_IMAGE_HEIGHT;
+	frame->width = width;
+	frame->height = height;
+	frame->result.imageWidth = width;
+	frame->result.imageHeight = height;
+	ChooseSearchArea(frame, pixels, pixelStride);
+	
+	for (int i = 0; i < frame->searchAreaCount; i++)
+	{
+		ParticleRect *area = &frame->searchAreas[i];
+		ApplyThreshold(pixels + area->top * pixelStride + area->left * 4, pixelStride,
+				frame->mask + area->top * frame->maskStride + area->left, frame->maskStride, area->width, area->height);
+	}
+}
+
+/**
+ * Thresholds pixels in whichever colors the pipeline was told it is getting.
+ */
+void VisionPipeline::ApplyThreshold(const unsigned char *pixels, int pixelStride, unsigned char *mask, int maskStride,
+		int width, int height) const
+{
+	if (ycbcrThreshold)
+		ycbcrThreshold->Apply(pixels, pixelStride, mask, maskStride, width, height);
+	else
+		threshold.Apply(pixels, pixelStride, mask, maskStride, width, height);
+}
+
+/**
+ * Finds, fills in and filters the particles in the part of the frame's mask that was thresholded.
+ */
+void VisionPipeline::Label(VisionFrame *frame)
+{
+	frame->particleCount = frame->labeler.Label(frame->mask, frame->maskStride, frame->width, frame->height,
+			frame->searchAreas, frame->searchAreaCount, areaMinimum(frame->width));
+}
+
+/**
+ * Adds a rectangle to the frame's search areas, merging it with any area it overlaps or touches,
+ * corners included, so the areas never overlap or touch each other and a particle is never split
+ * across two of them. The areas are kept sorted by their left edge.
+ * 
+ * @return False if there was no room left for the rectangle
+ */
+static bool addSearchArea(VisionFrame *frame, ParticleRect rect)
+{
+	ParticleRect *areas = frame->searchAreas;
+	int i = 0;
+	
+	while (i < frame->searchAreaCount)
+	{
+		ParticleRect *area = &areas[i];
+		if (area->left <= rect.left + rect.width && rect.left <= area->left + area->width
+				&& area->top <= rect.top + rect.height && rect.top <= area->top + area->height)
+		{
+			//take the overlapping or touching area out and start over with the two of them combined
+			int right = area->left + area->width > rect.left + rect.width ? area->left + area->width : rect.left + rect.width;
+			int bottom = area->top + area->height > rect.top + rect.height ? area->top + area->height : rect.top + rect.height;
+			if (area->left < rect.left) rect.left = area->left;
+			if (area->top < rect.top) rect.top = area->top;
+			rect.width = right - rect.left;
+			rect.height = bottom - rect.top;
+			for (int j = i + 1; j < frame->searchAreaCount; j++)
+				areas[j - 1] = areas[j];
+			frame->searchAreaCount--;
+			i = 0;
+			continue;
+		}
+		i++;
+	}
+	if (frame->searchAreaCount == MAX_SEARCH_AREAS)
+		return false;
+	
+	i = frame->searchAreaCount++;
+	while (i > 0 && areas[i - 1].left > rect.left)
+	{
+		areas[i] = areas[i - 1];
+		i--;
+	}
+	areas[i] = rect;
+	return true;
+}
+
+/**
+ * Searches a shrunken copy of the image for particles and turns each one into a search area at
+ * full resolution. The copy takes every factor'th pixel of every factor'th row, which keeps the
+ * colors exact for the threshold.
+ * 
+ * @param factor How many times smaller the copy is in each direction
+ */
+void VisionPipeline::FindCandidates(VisionFrame *frame, const unsigned char *pixels, int pixelStride, int factor)
+{
+	int coarseWidth = frame->width / factor;
+	int coarseHeight = frame->height / factor;
+	int margin = scaleToWidth(CANDIDATE_MARGIN, frame->width);
+	
+	for (int y = 0; y < coarseHeight; y++)
+	{
+		const unsigned int *in = (const unsigned int *) (pixels + y * factor * pixelStride);
+		unsigned int *out = (unsigned int *) (frame->coarsePixels + y * coarseWidth * 4);
+		for (int x = 0; x < coarseWidth; x++)
+			out[x] = in[x * factor];
+	}
+	ApplyThreshold(frame->coarsePixels, coarseWidth * 4, frame->coarseMask, coarseWidth, coarseWidth, coarseHeight);
+	int count = frame->labeler.Label(frame->coarseMask, coarseWidth, coarseWidth, coarseHeight, areaMinimum(coarseWidth));
+	
+	frame->searchAreaCount = 0;
+	for (int i = 0; i < count; i++)
+	{
+		ParticleRect *found = &frame->labeler.GetParticle(i)->boundingRect;
+		int left = found->left * factor - margin;
+		int top = found->top * factor - margin;
+		int right = (found->left + found->width) * factor + margin;
+		int bottom = (found->top + found->height) * factor + margin;
+		if (left < 0) left = 0;
+		if (top < 0) top = 0;
+		if (right > frame->width) right = frame->width;
+		if (bottom > frame->height) bottom = frame->height;
+		
+		ParticleRect rect;
+		rect.left = left;
+		rect.top = top;
+		rect.width = right - left;
+		rect.height = bottom - top;
+		if (!addSearchArea(frame, rect))
+		{
+			//too many candidates to be worth it, search everything
+			rect.left = 0;
+			rect.top = 0;
+			rect.width = frame->width;
+			rect.height = frame->height;
+			frame->searchAreas[0] = rect;
+			frame->searchAreaCount = 1;
+			return;
+		}
+	}
+}
+
+/**
+ * Picks the parts of the image to search: a window around the last high goal while tracking
+ * one, the areas around the candidates in a shrunken copy of the image in coarse to fine mode,
+ * otherwise the whole image.
+ */
+void VisionPipeline::ChooseSearchArea(VisionFrame *frame, const unsigned char *pixels, int pixelStride)
+{
+	ParticleRect *area = &frame->searchAreas[0];
+	int factor = frame->width / COARSE_WIDTH;
+	
+	if (tracking && haveTarget && framesSinceFullSearch < fullFrameInterval)
+	{
+		int marginX = lastTarget.width + scaleToWidth(ROI_MARGIN, frame->width);
+		int marginY = lastTarget.height + scaleToWidth(ROI_MARGIN, frame->width);
+		int left = lastTarget.left - marginX;
+		int top = lastTarget.top - marginY;
+		int right = lastTarget.left + lastTarget.width + marginX;
+		int bottom = lastTarget.top + lastTarget.height + marginY;
+		if (left < 0) left = 0;
+		if (top < 0) top = 0;
+		if (right > frame->width) right = frame->width;
+		if (bottom > frame->height) bottom = frame->height;
+		
+		if (right > left && bottom > top)
+		{
+			area->left = left;
+			area->top = top;
+			area->width = right - left;
+			area->height = bottom - top;
+			frame->searchAreaCount = 1;
+			frame->result.tracked = true;
+			framesSinceFullSearch++;
+			return;
+		}
+	}
+	frame->result.tracked = false;
+	framesSinceFullSearch = 0;
+	if (coarseToFine && factor >= 2)
+	{
+		FindCandidates(frame, pixels, pixelStride, factor);
+		return;
+	}
+	area->left = 0;
+	area->top = 0;
+	area->width = frame->width;
+	area->height = frame->height;
+	frame->searchAreaCount = 1;
+}
+
+/**
+ * Remembers where the high goal was for the next frame. A goal cut off by the edge of the
+ * search area it was found in can't be trusted, so that counts as losing it.
+ */
+void VisionPipeline::UpdateTracking(VisionFrame *frame)
+{
+	ParticleRect *area = frame->searchAreas;
+	ParticleRect *high = &frame->highRect;
+	
+	haveTarget = false;
+	if (!frame->result.isHighGoal)
+		return;
+	while (area < frame->searchAreas + frame->searchAreaCount - 1
+			&& (high->left < area->left || high->left >= area->left + area->width
+			|| high->top < area->top || high->top >= area->top + area->height))
+		area++;
+	if ((high->left <= area->left && area->left > 0)
+			|| (high->top <= area->top && area->top > 0)
+			|| (high->left + high->width >= area->left + area->width && area->left + area->width < frame->width)
+			|| (high->top + high->height >= area->top + area->height && area->top + area->height < frame->height))
+		return;
+	haveTarget = true;
+	lastTarget = *high;
+}
+
+/**
+ * Scores every particle in the frame and records the high and middle goals that were found.
+ * The result gets the last high goal scored; all of them are kept in highDetections for a
+ * TargetTracker to choose between.
+ */
+void VisionPipeline::Score(VisionFrame *frame)
+{
+	Scores *scores = frame->scores;
+	double slack = edgeSlack(frame->width);
+	
+	//Iterate through each particle, scoring it and determining whether it is a target or not
+	frame->result.isHighGoal=false;
+	frame->result.highTrackId=0;
+	frame->result.isMidGoal=false;
+	frame->highDetectionCount=0;
+	for (int i = 0; i < frame->particleCount; i++) {
+		ParticleReport *report = frame->labeler.GetParticle(i);
+		
+		//measure the particle once, then compare it with every kind of target
+		double aspectRatio = measureAspectRatio(report);
+		scores[i].rectangularity = scoreRectangularity(report);
+		scores[i].xEdge = scoreXEdge(report, slack);
+		scores[i].yEdge = scoreYEdge(report, slack);
+		scores[i].target = TARGET_NONE;
+		for (int type = 0; type < TARGET_TYPES; type++) {
+			scores[i].aspectRatio[type] = scoreAspectRatio(aspectRatio, targetDescriptors[type]);
+			if (scores[i].target == TARGET_NONE && scoreCompare(scores[i], type))
+				scores[i].target = type;
+		}
+		
+		if(scores[i].target == TARGET_HIGH)
+		{
+			//printf("particle: %d  is a High Goal  centerX: %f  centerY: %f \n", i, report->center_mass_x_normalized, report->center_mass_y_normalized);
+			//printf("Distance: %f \n", computeDistance(report, false, calibration));
+			frame->result.isHighGoal=true;
+			
+			frame->result.highX=report->center_mass_x;
+			frame->result.highY=report->center_mass_y;
+			frame->result.highWidth=report->boundingRect.width;
+			frame->result.highHeight=report->boundingRect.height;
+			frame->highRect=report->boundingRect;
+			frame->result.highCenterXNormal=report->center_mass_x_normalized;
+			frame->result.highCenterYNormal=report->center_mass_y_normalized;
+			frame->result.highDistance=computeDistance(report, false, calibration);
+			frame->result.highDistance2=computeDistance2(report, calibration);
+			
+			TargetDetection *detection = &frame->highDetections[frame->highDetectionCount++];
+			detection->x=report->center_mass_x;
+			detection->y=report->center_mass_y;
+			detection->width=report->boundingRect.width;
+			detection->height=report->boundingRect.height;
+			detection->distance=frame->result.highDistance;
+			detection->distance2=frame->result.highDistance2;
+		} else if (scores[i].target == TARGET_MID) {
+			//printf("particle: %d  is a Middle Goal  centerX: %f  centerY: %f \n", i, report->center_mass_x_normalized, report->center_mass_y_normalized);
+			//printf("Distance: %f \n", computeDistance(report, true, calibration));
+			frame->result.isMidGoal=true;
+			frame->result.midCenterX=report->center_mass_x_normalized;
+			frame->result.midCenterY=report->center_mass_y_normalized;
+			frame->result.midDistance=computeDistance(report, true, calibration);
+			frame->result.midDistance2=computeDistance2(report, calibration);
+		} else {
+			//printf("particle: %d  is not a goal  centerX: %f  centerY: %f \n", i, report->center_mass_x_normalized, report->center_mass_y_normalized);
+		}
+		
+		//printf("rect: %f  ARhigh: %f \n", scores[i].rectangularity, scores[i].aspectRatio[TARGET_HIGH]);
+		//printf("ARmid: %f  xEdge: %f  yEdge: %f  \n", scores[i].aspectRatio[TARGET_MID], scores[i].xEdge, scores[i].yEdge);	
+	}
+	UpdateTracking(frame);
+}
+
+/**
+ * Runs every step of the pipeline on one camera image. If a tracked search loses the high
+ * goal, the whole image is searched again straight away instead of waiting for the next frame.
+ */
+void VisionPipeline::Process(VisionFrame *frame, const unsigned char *pixels, int pixelStride, int width, int height)
+{
+	Threshold(frame, pixels, pixelStride, width, height);
+	Label(frame);
+	Score(frame);
+	if (frame->result.tracked && !frame->result.isHighGoal)
+	{
+		Threshold(frame, pixels, pixelStride, width, height);
+		Label(frame);
+		Score(frame);
+	}
+}
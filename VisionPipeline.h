@@ -0,0 +1,189 @@
+#ifndef VISIONPIPELINE_H
+#define VISIONPIPELINE_H
+
+#include "HSVThreshold.h"
+#include "YCbCrThreshold.h"
+#include "ParticleLabeler.h"
+#include "VisionResult.h"
+#include "TargetTracker.h"
+#include "VisionCalibration.h"
+#include <stddef.h>
+
+//The camera constants used for distance calculation are in VisionCalibration
+#define X_IMAGE_RES 320		//X Image resolution the pixel limits below were tuned at, other resolutions are scaled from it
+
+//Score limits used for target identification
+#define RECTANGULARITY_LIMIT 60
+#define ASPECT_RATIO_LIMIT 75
+#define X_EDGE_LIMIT 40
+#define Y_EDGE_LIMIT 60
+
+//Minimum area of particles to be considered
+#define AREA_MINIMUM 500
+
+//Storage limits for each frame, sized for the largest camera resolution
+#define MAX_IMAGE_WIDTH 640
+#define MAX_IMAGE_HEIGHT 480
+#define MAX_RUNS 16384
+#define MAX_PARTICLES 64
+
+//Tracking mode: pixels searched past the last high goal on each side (on top of its own
+//width and height), and how many tracked frames to allow between full frame searches
+#define ROI_MARGIN 16
+#define FULL_FRAME_INTERVAL 10
+
+//Coarse to fine mode: width of the downsampled image searched for candidates, pixels (at
+//X_IMAGE_RES) added around each candidate before refining it, and most areas refined per frame
+#define COARSE_WIDTH 160
+#define CANDIDATE_MARGIN 8
+#define MAX_SEARCH_AREAS 8
+
+//Edge profile constants used for hollowness score calculation
+#define XMAXSIZE 24
+#define XMINSIZE 24
+#define YMAXSIZE 24
+#define YMINSIZE 48
+const double xMax[XMAXSIZE] = {1, 1, 1, 1, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, 1, 1, 1, 1};
+const double xMin[XMINSIZE] = {.4, .6, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, .1, 0.6, 0};
+const double yMax[YMAXSIZE] = {1, 1, 1, 1, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, .5, 1, 1, 1, 1};
+const double yMin[YMINSIZE] = {.4, .6, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05,
+								.05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05, .05,
+								.05, .05, .6, 0};
+
+//Kinds of target the scoring looks for, in the order a particle is checked against them
+enum TargetType {
+	TARGET_HIGH,
+	TARGET_MID,
+	TARGET_TYPES,
+	TARGET_NONE = -1
+};
+
+//What a kind of target looks like, and how close a particle's scores must come to count as one
+struct TargetDescriptor {
+	const char *name;
+	double aspectRatio;			//width over height of the tape's outer edge
+	double rectangularityLimit;
+	double aspectRatioLimit;
+	double xEdgeLimit;
+	double yEdgeLimit;
+};
+
+//Dimensions of goal opening + 4 inches on all 4 sides for reflective tape. A new kind of
+//target only needs an entry here and in TargetType: every particle is measured once and the
+//measurements are compared with each descriptor in turn.
+const TargetDescriptor targetDescriptors[TARGET_TYPES] = {
+	{"high", 62.0 / 20, RECTANGULARITY_LIMIT, ASPECT_RATIO_LIMIT, X_EDGE_LIMIT, Y_EDGE_LIMIT},
+	{"mid", 62.0 / 29, RECTANGULARITY_LIMIT, ASPECT_RATIO_LIMIT, X_EDGE_LIMIT, Y_EDGE_LIMIT}
+};
+
+//Structure to represent the scores for the various tests used for target identification
+struct Scores {
+	double rectangularity;
+	double aspectRatio[TARGET_TYPES];	//against each descriptor's ideal aspect ratio
+	double xEdge;
+	double yEdge;
+	int target;							//first TargetType the particle matched, or TARGET_NONE
+};
+
+/**
+ * Everything one frame needs on its way through the pipeline: the threshold mask, the particle
+ * tables, the scores and the result. All of it is allocated by the constructor
+ * and sized for the largest resolution, so a frame can be reused forever without touching the heap.
+ */
+class VisionFrame
+{
+public:
+	int width;
+	int height;
+	ParticleRect searchAreas[MAX_SEARCH_AREAS];	//the parts of the image that were thresholded and labeled
+	int searchAreaCount;
+	ParticleRect highRect;		//bounding rect of the high goal, if one was found
+	TargetDetection highDetections[MAX_PARTICLES];	//every particle that scored as a high goal, for a TargetTracker
+	int highDetectionCount;
+	unsigned char *mask;
+	int maskStride;
+	unsigned char *coarsePixels;	//downsampled copy of the image for the coarse search
+	unsigned char *coarseMask;
+	ParticleLabeler labeler;
+	int particleCount;
+	Scores scores[MAX_PARTICLES];
+
+	VisionResult result;		//sequence and timestamp are filled in by whoever captured the frame
+
+	VisionFrame(void);
+	~VisionFrame();
+};
+
+/**
+ * The image processing steps Vision2823 runs on every camera frame, kept free of WPILib and
+ * IMAQ so they can also be run on a PC. Each step can be called on its own, or Process() runs
+ * them all.
+ *
+ * With tracking turned on, once a high goal is found the following frames are only searched
+ * in a window around it. The whole frame is searched again as soon as the goal is lost, when
+ * it touches the edge of the window, and every fullFrameInterval frames to pick up new targets.
+ *
+ * With coarse to fine turned on, a full search first thresholds and labels a copy of the image
+ * shrunk to about COARSE_WIDTH, then only the areas around the particles found there are searched
+ * at full resolution. A 640 wide image costs little more than a 160 wide scan this way, while the
+ * goals are still measured at 640. Everything measured in pixels (the area minimum, the margins
+ * and the distance math) is scaled from X_IMAGE_RES to the resolution actually being searched.
+ */
+class VisionPipeline
+{
+private:
+	HSVThreshold threshold;
+	VisionCalibration calibration;
+	const YCbCrThreshold *ycbcrThreshold;	//set when the pixels are YCbCr straight from the JPEG
+	bool tracking;
+	bool coarseToFine;
+	int fullFrameInterval;
+	int framesSinceFullSearch;
+	bool haveTarget;
+	ParticleRect lastTarget;
+
+	void ChooseSearchArea(VisionFrame *frame, const unsigned char *pixels, int pixelStride);
+	void FindCandidates(VisionFrame *frame, const unsigned char *pixels, int pixelStride, int factor);
+	void UpdateTracking(VisionFrame *frame);
+	void ApplyThreshold(const unsigned char *pixels, int pixelStride, unsigned char *mask, int maskStride,
+			int width, int height) const;
+
+public:
+	VisionPipeline(void) : threshold(60, 130, 90, 255, 20, 255) //HSV threshold criteria, ranges are in that order ie. Hue is 60-100
+	{
+		ycbcrThreshold = NULL;
+		tracking = false;
+		coarseToFine = false;
+		fullFrameInterval = FULL_FRAME_INTERVAL;
+		framesSinceFullSearch = 0;
+		haveTarget = false;
+	}
+
+	void SetTracking(bool enabled, int full_frame_interval = FULL_FRAME_INTERVAL)
+	{
+		tracking = enabled;
+		fullFrameInterval = full_frame_interval;
+		haveTarget = false;
+	}
+
+	void SetCoarseToFine(bool enabled) { coarseToFine = enabled; }
+
+	/**
+	 * Replaces the compiled in camera calibration the distances are worked out with.
+	 */
+	void SetCalibration(const VisionCalibration &in_calibration) { calibration = in_calibration; }
+
+	/**
+	 * Tells the pipeline the pixels it is given are YCbCr, to be thresholded with a table built
+	 * from GetThreshold(). NULL goes back to blue, green, red pixels.
+	 */
+	void SetYCbCrThreshold(const YCbCrThreshold *table) { ycbcrThreshold = table; }
+	const HSVThreshold &GetThreshold(void) const { return threshold; }
+
+	void Threshold(VisionFrame *frame, const unsigned char *pixels, int pixelStride, int width, int height);
+	void Label(VisionFrame *frame);
+	void Score(VisionFrame *frame);
+	void Process(VisionFrame *frame, const unsigned char *pixels, int pixelStride, int width, int height);
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef VISIONRESULT_H
+#define VISIONRESULT_H
+
+#include "AtomicOps.h"
+
+/**
+ * Everything the vision task found in one camera frame. The high goal fields are only
+ * meaningful when isHighGoal is set, and the middle goal fields when isMidGoal is set.
+ */
+struct VisionResult {
+	unsigned long sequence;		//frame number, 0 until the first frame is published
+	double timestamp;			//FPGA time in seconds when the frame was captured
+	bool tracked;				//only a window around the last high goal was searched
+	int imageWidth;				//size of the frame the pixel fields are measured in
+	int imageHeight;
+
+	bool isHighGoal;
+	double highCenterXNormal;
+	double highCenterYNormal;
+	double highDistance;
+	double highDistance2;
+	int highX;
+	int highY;
+	int highWidth;
+	int highHeight;
+	int highTrackId;			//target the high goal fields follow from frame to frame, 0 if untracked
+	double highConfidence;		//0 to 1, how steadily that target has been seen
+	double highAge;				//seconds since it was first seen
+	int highMisses;				//frames in a row it has not been seen, its position being predicted
+
+	bool isMidGoal;
+	double midCenterX;
+	double midCenterY;
+	double midDistance;
+	double midDistance2;
+};
+
+/**
+ * Hands VisionResult snapshots from the vision task to the control loop without a lock.
+ *
+ * There are two slots, each with its own sequence lock. The writer always fills the slot the
+ * reader is not being pointed at and then flips the pointer, so a reader only has to retry if
+ * two whole frames are published while it is copying one. On the single core cRIO the control
+ * loop runs at a higher priority than vision, so a read that interrupts Publish() always finds
+ * a finished slot and Read() never waits on the vision task.
+ *
+ * Only one task may call Publish(). Any number of tasks may call Read().
+ */
+class VisionResultBuffer
+{
+private:
+	struct Slot {
+		volatile unsigned long version;		//odd while the slot is being written
+		VisionResult result;
+	};
+	Slot slots[2];
+	volatile int latest;
+
+public:
+	VisionResultBuffer(void)
+	{
+		slots[0].version = 0;
+		slots[1].version = 0;
+		slots[0].result.sequence = 0;
+		slots[0].result.timestamp = 0;
+		slots[0].result.tracked = false;
+		slots[0].result.imageWidth = 0;
+		slots[0].result.imageHeight = 0;
+		slots[0].result.isHighGoal = false;
+		slots[0].result.highTrackId = 0;
+		slots[0].result.isMidGoal = false;
+		latest = 0;
+	}
+
+	void Publish(const VisionResult &result)
+	{
+		int index = 1 - latest;
+		Slot *slot = &slots[index];
+		slot->version++;
+		MEMORY_BARRIER();
+		slot->result = result;
+		MEMORY_BARRIER();
+		slot->version++;
+		MEMORY_BARRIER();
+		latest = index;
+	}
+
+	/**
+	 * Copies out the newest complete snapshot.
+	 */
+	void Read(VisionResult *result) const
+	{
+		for (;;)
+		{
+			const Slot *slot = &slots[latest];
+			unsigned long before = slot->version;
+			MEMORY_BARRIER();
+			*result = slot->result;
+			MEMORY_BARRIER();
+			if ((before & 1) == 0 && slot->version == before)
+				return;
+		}
+	}
+};
+
+#endif
@@ -0,0 +1,121 @@
+#include "YCbCrThreshold.h"
+#include <string.h>
+#include <stddef.h>
+
+/**
+ * Color threshold for JPEG YCbCr pixels. See YCbCrThreshold.h.
+ */
+
+//Byte offsets inside a YCbCr pixel
+#define Y_OFFSET 0
+#define CB_OFFSET 1
+#define CR_OFFSET 2
+#define PIXEL_SIZE 4
+
+//Fixed point used by the libjpeg color conversion (jdcolor.c)
+#define SCALEBITS 16
+#define ONE_HALF (1 << (SCALEBITS - 1))
+#define FIX(x) ((int) ((x) * (1 << SCALEBITS) + 0.5))
+
+static int clamp(int value)
+{
+	if (value < 0)
+		return 0;
+	if (value > 255)
+		return 255;
+	return value;
+}
+
+/**
+ * Converts one pixel from JPEG YCbCr to RGB exactly the way libjpeg does when it decodes to RGB.
+ */
+void YCbCrThreshold::ToRGB(int y, int cb, int cr, int *r, int *g, int *b)
+{
+	int x = cr - 128;
+	int w = cb - 128;
+	*r = clamp(y + ((FIX(1.40200) * x + ONE_HALF) >> SCALEBITS));
+	*g = clamp(y + ((-FIX(0.34414) * w + ONE_HALF - FIX(0.71414) * x) >> SCALEBITS));
+	*b = clamp(y + ((FIX(1.77200) * w + ONE_HALF) >> SCALEBITS));
+}
+
+/**
+ * Builds the table for an HSV threshold.
+ */
+YCbCrThreshold::YCbCrThreshold(const HSVThreshold &threshold)
+{
+	unsigned char *bits = new unsigned char[1 << 21];
+	bool ranged = true;
+	ranges = new unsigned char[2 << 16];
+	memset(bits, 0, 1 << 21);
+	for (int cb = 0; cb < 256; cb++)
+	{
+		for (int cr = 0; cr < 256; cr++)
+		{
+			unsigned char *row = bits + ((cb << 13) | (cr << 5));
+			unsigned char *range = ranges + 2 * ((cb << 8) | cr);
+			int low = 256, high = -1, count = 0;
+			for (int y = 0; y < 256; y++)
+			{
+				int r, g, b;
+				ToRGB(y, cb, cr, &r, &g, &b);
+				if (threshold.Test(b, g, r))
+				{
+					row[y >> 3] |= 1 << (y & 7);
+					if (low > y) low = y;
+					high = y;
+					count++;
+				}
+			}
+			if (count && count != high - low + 1)
+				ranged = false;
+			range[0] = count ? low : 1;
+			range[1] = count ? high : 0;
+		}
+	}
+	if (ranged)
+	{
+		delete [] bits;
+		table = NULL;
+	}
+	else
+	{
+		table = bits;
+	}
+}
+
+YCbCrThreshold::~YCbCrThreshold()
+{
+	delete [] table;
+	delete [] ranges;
+}
+
+/**
+ * Thresholds a YCbCr image into a mask of the same size.
+ *
+ * @param pixels First pixel of the image, 4 bytes per pixel (Y, Cb, Cr, unused)
+ * @param pixelStride Bytes from the start of one image row to the next
+ * @param mask First byte of the output mask, one byte per pixel
+ * @param maskStride Bytes from the start of one mask row to the next
+ * @param width Width of the area to threshold in pixels
+ * @param height Height of the area to threshold in pixels
+ */
+void YCbCrThreshold::Apply(const unsigned char *pixels, int pixelStride, unsigned char *mask, int maskStride,
+		int width, int height) const
+{
+	for (int row = 0; row < height; row++)
+	{
+		const unsigned char *p = pixels + row * pixelStride;
+		unsigned char *out = mask + row * maskStride;
+		if (table)
+		{
+			for (int x = 0; x < width; x++, p += PIXEL_SIZE)
+				out[x] = Test(p[Y_OFFSET], p[CB_OFFSET], p[CR_OFFSET]);
+			continue;
+		}
+		for (int x = 0; x < width; x++, p += PIXEL_SIZE)
+		{
+			const unsigned char *range = ranges + 2 * ((p[CB_OFFSET] << 8) | p[CR_OFFSET]);
+			out[x] = p[Y_OFFSET] >= range[0] && p[Y_OFFSET] <= range[1];
+		}
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef YCBCRTHRESHOLD_H
+#define YCBCRTHRESHOLD_H
+
+#include "HSVThreshold.h"
+
+/**
+ * The same color threshold as an HSVThreshold, applied to pixels that are still in the YCbCr
+ * colors a JPEG is stored in, so a frame can be thresholded without ever being converted to RGB.
+ *
+ * The constructor runs every possible Y, Cb, Cr triple through the JPEG YCbCr to RGB conversion,
+ * with the same fixed point math and rounding as libjpeg, and then through HSVThreshold::Test(),
+ * so a pixel thresholds to exactly what it would have if it had been decoded to RGB first. For
+ * any color (Cb, Cr) the brightnesses that pass are normally one unbroken range of Y, so the
+ * table only keeps the lowest and highest Y for each color (128 KB). If some color doesn't work
+ * that way, a full table of 2^24 bits (2 MB) is kept instead. Either way a pixel costs one table
+ * lookup. The table takes a moment to build, so make one when the vision code starts up and
+ * share it.
+ *
+ * Pixels are 4 bytes each: Y, Cb, Cr and one unused byte, the layout JpegFrameDecoder writes.
+ *
+ * This file does not use WPILib so the same threshold can be run on the robot and on a PC.
+ */
+class YCbCrThreshold
+{
+private:
+	unsigned char *ranges;	//lowest and highest passing Y at 2 * ((cb << 8) | cr), empty when lowest > highest
+	unsigned char *table;	//NULL, or bit y of byte (cb << 13) | (cr << 5) | (y >> 3)
+
+public:
+	YCbCrThreshold(const HSVThreshold &threshold);
+	~YCbCrThreshold();
+
+	static void ToRGB(int y, int cb, int cr, int *r, int *g, int *b);
+
+	bool Test(int y, int cb, int cr) const
+	{
+		if (table)
+			return (table[(cb << 13) | (cr << 5) | (y >> 3)] >> (y & 7)) & 1;
+		const unsigned char *range = ranges + 2 * ((cb << 8) | cr);
+		return y >= range[0] && y <= range[1];
+	}
+
+	void Apply(const unsigned char *pixels, int pixelStride, unsigned char *mask, int maskStride,
+			int width, int height) const;
+};
+
+#endif
@@ -0,0 +1,604 @@
+#ifndef _WRS_KERNEL
+
+#include "WPILib.h"
+#include "Simulation.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+/**
+ * Simulated robot behind sim/WPILib.h: a virtual clock, the device models, the joystick script,
+ * and the WPILib classes the robot code uses, which read and write the models.
+ *
+ * The clock only moves inside SimAdvance(), which is what Wait() is. It moves in steps of at most
+ * SIM_STEP, stopping exactly on each Notifier's time, and after each step the models are moved
+ * on and any Notifier handlers that are due run, as the Notifier task would on the cRIO. The
+ * clock never goes backwards, including across SimReset(), so the robot object and its control
+ * loops can be kept from one run to the next.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+
+struct SimScriptEvent {
+	double time;		//seconds after the start of the mode
+	bool isAxis;
+	int index;
+	float value;
+};
+
+static bool operator<(const SimScriptEvent &a, const SimScriptEvent &b)
+{
+	return a.time < b.time;
+}
+
+static SimParameters parameters = SimDefaultParameters();
+static FlywheelSim shooter(parameters.shooter);
+static long pickupBase;		//counts from before the last reset, so the encoder never jumps back
+static double now;
+static SimMode mode;
+static double modeStart;
+static double modeEnd;
+static float pwm[SIM_PWM_CHANNELS];
+static Relay::Value relays[SIM_RELAY_CHANNELS];
+static float axes[SIM_JOYSTICKS][SIM_JOYSTICK_AXES];
+static bool buttons[SIM_JOYSTICKS][SIM_JOYSTICK_BUTTONS];
+static double hurricane;	//turns of the hurricane
+static double angle;		//0 at the reverse limit to 1 at the forward limit
+static int discs;
+static SimShot shots[SIM_MAX_SHOTS];
+static int shotCount;
+static std::vector<SimScriptEvent> script;
+static unsigned scriptNext;
+static Notifier *notifiers;	//queued notifiers, soonest first
+
+SimParameters SimDefaultParameters(void)
+{
+	SimParameters p;
+	p.shooter = FlywheelSim::DefaultParameters();
+	p.hurricaneTurn = 0.6;
+	p.switchOn = 0.1;
+	p.switchOff = 0.5;
+	p.discRelease = 0.3;
+	p.discs = 8;
+	p.angleTravel = 5.5;
+	p.angleStart = 0;
+	return p;
+}
+
+/**
+ * Sets the devices back to how the parameters say they start, stops the motors and relays,
+ * releases the joystick and loads the discs. The clock and any queued Notifiers carry on.
+ */
+void SimReset(const SimParameters &in_parameters)
+{
+	parameters = in_parameters;
+	pickupBase += shooter.GetCount();
+	shooter = FlywheelSim(parameters.shooter);
+	for (int i = 0; i < SIM_PWM_CHANNELS; i++)
+		pwm[i] = 0;
+	for (int i = 0; i < SIM_RELAY_CHANNELS; i++)
+		relays[i] = Relay::kOff;
+	memset(axes, 0, sizeof(axes));
+	memset(buttons, 0, sizeof(buttons));
+	hurricane = 0;
+	angle = parameters.angleStart;
+	discs = parameters.discs;
+	shotCount = 0;
+	mode = SIM_DISABLED;
+	modeStart = modeEnd = now;
+	scriptNext = script.size();
+}
+
+/**
+ * Starts a match period. The robot's IsEnabled() turns false after duration seconds, and the
+ * joystick script, if one is loaded, plays from the start.
+ */
+void SimStartMode(SimMode in_mode, double duration)
+{
+	mode = in_mode;
+	modeStart = now;
+	modeEnd = now + duration;
+	scriptNext = 0;
+}
+
+static void StepDevices(double dt)
+{
+	shooter.SetCommand(pwm[SIM_SHOOTER_PWM]);
+	shooter.Step(dt);
+
+	if (relays[SIM_HURRICANE_RELAY] != Relay::kOff)
+	{
+		double before = hurricane - (long) hurricane;
+		hurricane += dt / parameters.hurricaneTurn;
+		double after = hurricane - (long) hurricane;
+		bool released = after < before ? (before < parameters.discRelease || after >= parameters.discRelease)
+				: (before < parameters.discRelease && after >= parameters.discRelease);
+		if (released && discs > 0)
+		{
+			shooter.FireDisc();
+			discs--;
+			if (shotCount < SIM_MAX_SHOTS)
+			{
+				shots[shotCount].time = now + dt;
+				shots[shotCount].speed = shooter.GetSpeed();
+				shotCount++;
+			}
+		}
+	}
+
+	if (relays[SIM_ANGLE_RELAY] == Relay::kForward)
+		angle = std::min(1.0, angle + dt / parameters.angleTravel);
+	else if (relays[SIM_ANGLE_RELAY] == Relay::kReverse)
+		angle = std::max(0.0, angle - dt / parameters.angleTravel);
+}
+
+static void PlayScript(void)
+{
+	while (scriptNext < script.size() && modeStart + script[scriptNext].time <= now)
+	{
+		const SimScriptEvent &e = script[scriptNext++];
+		if (e.isAxis)
+			SimSetAxis(1, e.index, e.value);
+		else
+			SimSetButton(1, e.index, e.value != 0);
+	}
+}
+
+/**
+ * Runs any Notifier handlers due by the time given, oldest first, with the clock set to each
+ * one's time.
+ */
+void SimRunNotifiers(double until)
+{
+	while (notifiers && notifiers->expiration <= until)
+	{
+		Notifier *n = notifiers;
+		n->Dequeue();
+		if (n->periodic)
+			n->Queue(n->expiration + n->period);
+		n->handler(n->param);
+	}
+}
+
+/**
+ * When the next Notifier is due, or the limit if that's sooner.
+ */
+double SimNextNotifier(double limit)
+{
+	return notifiers && notifiers->expiration < limit ? notifiers->expiration : limit;
+}
+
+/**
+ * Moves the clock on, stepping the devices and running Notifiers and the script as it goes.
+ */
+void SimAdvance(double seconds)
+{
+	double end = now + seconds;
+	while (now < end)
+	{
+		double next = std::max(now, SimNextNotifier(std::min(end, now + SIM_STEP)));
+		StepDevices(next - now);
+		now = next;
+		SimRunNotifiers(now);
+		PlayScript();
+	}
+	SimRunNotifiers(now);
+	PlayScript();
+}
+
+double SimGetTime(void)
+{
+	return now;
+}
+
+double SimGetModeStart(void)
+{
+	return modeStart;
+}
+
+/**
+ * Copies out the discs shot since the last SimReset(), and returns how many there were.
+ */
+int SimGetShots(SimShot *out, int maxShots)
+{
+	int n = std::min(shotCount, maxShots);
+	for (int i = 0; i < n; i++)
+		out[i] = shots[i];
+	return shotCount;
+}
+
+double SimGetShooterSpeed(void)
+{
+	return shooter.GetSpeed();
+}
+
+double SimGetAnglePosition(void)
+{
+	return angle;
+}
+
+float SimGetPWM(int channel)
+{
+	return channel > 0 && channel < SIM_PWM_CHANNELS ? pwm[channel] : 0;
+}
+
+void SimSetAxis(int joystick, int axis, float value)
+{
+	if (joystick >= 1 && joystick <= SIM_JOYSTICKS && axis >= 1 && axis <= SIM_JOYSTICK_AXES)
+		axes[joystick - 1][axis - 1] = value;
+}
+
+void SimSetButton(int joystick, int button, bool pressed)
+{
+	if (joystick >= 1 && joystick <= SIM_JOYSTICKS && button >= 1 && button <= SIM_JOYSTICK_BUTTONS)
+		buttons[joystick - 1][button - 1] = pressed;
+}
+
+/**
+ * Loads a script for joystick 1, which plays from the start of every mode. One event per line:
+ *
+ *   <seconds> axis <axis> <value>
+ *   <seconds> button <button> <0|1>
+ *
+ * with seconds counted from the start of the mode. Blank lines and lines starting with # are
+ * skipped. The axes and buttons keep their values until the script changes them.
+ *
+ * @return false if the file can't be read or has a bad line
+ */
+bool SimLoadScript(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		printf("SimLoadScript: can't open %s\n", path);
+		return false;
+	}
+	std::vector<SimScriptEvent> events;
+	char line[256];
+	int lineNumber = 0;
+	bool ok = true;
+	while (ok && fgets(line, sizeof(line), file))
+	{
+		lineNumber++;
+		char kind[16];
+		SimScriptEvent e;
+		char *p = line;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0)
+			continue;
+		if (sscanf(p, "%lf %15s %d %f", &e.time, kind, &e.index, &e.value) != 4
+				|| (strcmp(kind, "axis") != 0 && strcmp(kind, "button") != 0))
+		{
+			printf("SimLoadScript: %s:%d: expected \"<seconds> axis|button <n> <value>\"\n", path, lineNumber);
+			ok = false;
+			break;
+		}
+		e.isAxis = strcmp(kind, "axis") == 0;
+		events.push_back(e);
+	}
+	fclose(file);
+	if (!ok)
+		return false;
+	std::stable_sort(events.begin(), events.end());
+	script = events;
+	scriptNext = script.size();
+	return true;
+}
+
+//WPILib stand-ins
+
+SEM_ID semMCreate(int options)
+{
+	(void) options;
+	static int semaphore;
+	return &semaphore;
+}
+
+STATUS semDelete(SEM_ID semaphore)
+{
+	(void) semaphore;
+	return 0;
+}
+
+void Wait(double seconds)
+{
+	if (seconds > 0)
+		SimAdvance(seconds);
+}
+
+double GetTime(void)
+{
+	return now;
+}
+
+Timer::Timer(void)
+{
+	startTime = now;
+	accumulated = 0;
+	running = false;
+}
+
+double Timer::Get(void)
+{
+	return running ? accumulated + now - startTime : accumulated;
+}
+
+void Timer::Reset(void)
+{
+	accumulated = 0;
+	startTime = now;
+}
+
+void Timer::Start(void)
+{
+	if (!running)
+	{
+		startTime = now;
+		running = true;
+	}
+}
+
+void Timer::Stop(void)
+{
+	if (running)
+	{
+		accumulated = Get();
+		running = false;
+	}
+}
+
+/**
+ * As in WPILib, moves the start on by the period rather than to now, so it doesn't drift.
+ */
+bool Timer::HasPeriodPassed(double period)
+{
+	if (Get() > period)
+	{
+		startTime += period;
+		return true;
+	}
+	return false;
+}
+
+double Timer::GetFPGATimestamp(void)
+{
+	return now;
+}
+
+Notifier::Notifier(TimerEventHandler in_handler, void *in_param)
+{
+	handler = in_handler;
+	param = in_param;
+	period = 0;
+	expiration = 0;
+	periodic = false;
+	queued = false;
+	next = NULL;
+}
+
+Notifier::~Notifier()
+{
+	Dequeue();
+}
+
+void Notifier::Queue(double when)
+{
+	Dequeue();
+	expiration = when;
+	Notifier **p = &notifiers;
+	while (*p && (*p)->expiration <= when)
+		p = &(*p)->next;
+	next = *p;
+	*p = this;
+	queued = true;
+}
+
+void Notifier::Dequeue(void)
+{
+	if (!queued)
+		return;
+	Notifier **p = &notifiers;
+	while (*p != this)
+		p = &(*p)->next;
+	*p = next;
+	next = NULL;
+	queued = false;
+}
+
+void Notifier::StartSingle(double delay)
+{
+	periodic = false;
+	period = delay;
+	Queue(now + delay);
+}
+
+void Notifier::StartPeriodic(double in_period)
+{
+	periodic = true;
+	period = in_period;
+	Queue(now + period);
+}
+
+void Notifier::Stop(void)
+{
+	Dequeue();
+}
+
+Jaguar::Jaguar(UINT32 in_channel)
+{
+	channel = in_channel < SIM_PWM_CHANNELS ? in_channel : 0;
+}
+
+void Jaguar::Set(float speed, UINT8 syncGroup)
+{
+	(void) syncGroup;
+	pwm[channel] = speed < -1 ? -1 : (speed > 1 ? 1 : speed);
+}
+
+float Jaguar::Get(void)
+{
+	return pwm[channel];
+}
+
+void Jaguar::Disable(void)
+{
+	pwm[channel] = 0;
+}
+
+void Jaguar::PIDWrite(float output)
+{
+	Set(output);
+}
+
+RobotDrive::RobotDrive(UINT32 leftMotorChannel, UINT32 rightMotorChannel)
+{
+	leftChannel = leftMotorChannel < SIM_PWM_CHANNELS ? leftMotorChannel : 0;
+	rightChannel = rightMotorChannel < SIM_PWM_CHANNELS ? rightMotorChannel : 0;
+}
+
+void RobotDrive::TankDrive(float leftValue, float rightValue)
+{
+	pwm[leftChannel] = leftValue;
+	pwm[rightChannel] = -rightValue;
+}
+
+Relay::Relay(UINT32 in_channel)
+{
+	channel = in_channel < SIM_RELAY_CHANNELS ? in_channel : 0;
+}
+
+void Relay::Set(Value value)
+{
+	relays[channel] = value;
+}
+
+Relay::Value Relay::Get(void)
+{
+	return relays[channel];
+}
+
+DigitalInput::DigitalInput(UINT32 in_channel)
+{
+	channel = in_channel;
+}
+
+/**
+ * Inputs with nothing simulated on them read 1, as an unconnected input does on the cRIO.
+ */
+UINT32 DigitalInput::Get(void)
+{
+	switch (channel)
+	{
+	case SIM_SHOOTER_PICKUP:
+		return (pickupBase + shooter.GetCount()) & 1;
+	case SIM_HURRICANE_SWITCH:
+	{
+		double turn = hurricane - (long) hurricane;
+		return turn >= parameters.switchOn && turn < parameters.switchOff;
+	}
+	case SIM_ANGLE_REVERSE_LIMIT:
+		return angle > 0;
+	case SIM_ANGLE_FORWARD_LIMIT:
+		return angle < 1;
+	default:
+		return 1;
+	}
+}
+
+Encoder::Encoder(DigitalSource &aSource, DigitalSource &bSource, bool reverseDirection,
+		EncodingType encodingType)
+{
+	(void) bSource;
+	(void) reverseDirection;
+	(void) encodingType;
+	channel = aSource.GetChannel();
+	offset = 0;
+	distancePerPulse = 1;
+	pidSource = kDistance;
+}
+
+Encoder::Encoder(UINT32 aChannel, UINT32 bChannel, bool reverseDirection, EncodingType encodingType)
+{
+	(void) bChannel;
+	(void) reverseDirection;
+	(void) encodingType;
+	channel = aChannel;
+	offset = 0;
+	distancePerPulse = 1;
+	pidSource = kDistance;
+}
+
+void Encoder::Reset(void)
+{
+	offset += Get();
+}
+
+/**
+ * Only the shooter's pickup is simulated; an encoder on any other channel stays at 0.
+ */
+INT32 Encoder::Get(void)
+{
+	if (channel != SIM_SHOOTER_PICKUP)
+		return 0;
+	return (INT32) (pickupBase + shooter.GetCount() - offset);
+}
+
+double Encoder::GetDistance(void)
+{
+	return Get() * distancePerPulse;
+}
+
+double Encoder::GetRate(void)
+{
+	return channel == SIM_SHOOTER_PICKUP ? shooter.GetSpeed() * distancePerPulse : 0;
+}
+
+double Encoder::PIDGet(void)
+{
+	return pidSource == kRate ? GetRate() : GetDistance();
+}
+
+Joystick::Joystick(UINT32 in_port)
+{
+	port = in_port;
+}
+
+float Joystick::GetRawAxis(UINT32 axis)
+{
+	if (port < 1 || port > SIM_JOYSTICKS || axis < 1 || axis > SIM_JOYSTICK_AXES)
+		return 0;
+	return axes[port - 1][axis - 1];
+}
+
+bool Joystick::GetRawButton(UINT32 button)
+{
+	if (port < 1 || port > SIM_JOYSTICKS || button < 1 || button > SIM_JOYSTICK_BUTTONS)
+		return false;
+	return buttons[port - 1][button - 1];
+}
+
+bool SimpleRobot::IsAutonomous(void)
+{
+	return mode == SIM_AUTONOMOUS;
+}
+
+bool SimpleRobot::IsOperatorControl(void)
+{
+	return mode == SIM_TELEOP;
+}
+
+bool SimpleRobot::IsEnabled(void)
+{
+	return mode != SIM_DISABLED && now < modeEnd;
+}
+
+bool SimpleRobot::IsDisabled(void)
+{
+	return !IsEnabled();
+}
+
+#endif
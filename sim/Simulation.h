@@ -0,0 +1,78 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "FlywheelSim.h"
+
+//Seconds between steps of the device models while the clock is moving
+#define SIM_STEP 0.001
+
+//Where things are wired on the robot, as in MyRobot.cpp
+#define SIM_SHOOTER_PWM 5
+#define SIM_SHOOTER_PICKUP 1		//digital input the shooter's magnetic pickup is on
+#define SIM_HURRICANE_SWITCH 2
+#define SIM_ANGLE_REVERSE_LIMIT 3	//ShooterAngleUp, opens at the end of Relay::kReverse travel
+#define SIM_ANGLE_FORWARD_LIMIT 4	//ShooterAngleDown, opens at the end of Relay::kForward travel
+#define SIM_ANGLE_RELAY 2
+#define SIM_HURRICANE_RELAY 3
+
+#define SIM_PWM_CHANNELS 11
+#define SIM_RELAY_CHANNELS 9
+#define SIM_JOYSTICKS 4
+#define SIM_JOYSTICK_AXES 6
+#define SIM_JOYSTICK_BUTTONS 12
+#define SIM_MAX_SHOTS 64
+
+/**
+ * What the simulated robot is like.
+ *
+ * The hurricane is the disc feeder. While its relay is on it turns once every hurricaneTurn
+ * seconds; its switch reads 1 from switchOn to switchOff of the way round and 0 the rest of the
+ * time, and a disc goes into the shooter at discRelease, as long as there are any left. The
+ * shooter angle motor runs the shooter between two limit switches, angleTravel seconds apart,
+ * each of which reads 0 once the shooter is against it.
+ */
+struct SimParameters {
+	FlywheelSimParameters shooter;
+	double hurricaneTurn;	//seconds per turn of the hurricane
+	double switchOn;		//fraction of a turn where the hurricane switch closes
+	double switchOff;		//fraction of a turn where it opens again
+	double discRelease;		//fraction of a turn where a disc is fed to the shooter
+	int discs;				//discs loaded
+	double angleTravel;		//seconds for the shooter to go from one limit to the other
+	double angleStart;		//where the shooter starts, 0 at the reverse limit to 1 at the forward one
+};
+
+enum SimMode { SIM_DISABLED, SIM_AUTONOMOUS, SIM_TELEOP };
+
+/**
+ * A disc that went through the shooter.
+ */
+struct SimShot {
+	double time;		//virtual time it was fed in
+	double speed;		//flywheel speed at that moment, counts/s
+};
+
+/**
+ * Control of the simulated robot that sim/WPILib.h stands in for. See sim/Simulation.cpp.
+ *
+ * Typical use: SimReset() once, create the robot, then for each run SimReset() again (the
+ * clock carries on, the devices and discs are set back), SimStartMode() and call the robot's
+ * Autonomous() or OperatorControl(), which return when the mode's time is up.
+ */
+SimParameters SimDefaultParameters(void);
+void SimReset(const SimParameters &parameters);
+void SimStartMode(SimMode mode, double duration);
+void SimAdvance(double seconds);
+double SimGetTime(void);
+double SimGetModeStart(void);
+
+int SimGetShots(SimShot *shots, int maxShots);
+double SimGetShooterSpeed(void);
+double SimGetAnglePosition(void);
+float SimGetPWM(int channel);
+
+void SimSetAxis(int joystick, int axis, float value);
+void SimSetButton(int joystick, int button, bool pressed);
+bool SimLoadScript(const char *path);
+
+#endif
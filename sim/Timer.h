@@ -0,0 +1 @@
+#include "WPILib.h"
@@ -0,0 +1,233 @@
+#ifndef SIM_WPILIB_H
+#define SIM_WPILIB_H
+
+/**
+ * Stand-in for WPILib.h that lets MyRobot.cpp build and run on a PC against simulated devices.
+ * Put sim/ ahead of everything else on the include path (g++ -Isim -I. ...) and link
+ * sim/Simulation.cpp, and the robot code compiles unchanged.
+ *
+ * Only the parts of WPILib the robot code uses are declared, with the same signatures. Time is
+ * virtual: Wait() and everything waiting on a Notifier move the clock on instantly, stepping
+ * the device models in sim/Simulation.h and running Notifier callbacks at their times as they
+ * go, all on the calling thread. Everything is deterministic, and a 15 second autonomous period
+ * takes milliseconds.
+ *
+ * Workbench never sees this file, since the robot build doesn't have sim/ on its include path.
+ */
+
+#include <stdio.h>
+#include <math.h>
+
+//Lets the robot code keep anything that would reach off the robot, such as the dashboard
+//datagrams, on this PC when it runs here
+#define WPILIB_SIMULATION 1
+
+typedef unsigned char UINT8;
+typedef unsigned int UINT32;
+typedef int INT32;
+typedef int STATUS;
+
+//semaphores do nothing, everything runs on one thread in virtual time
+typedef void *SEM_ID;
+#define SEM_Q_PRIORITY 0x1
+#define SEM_DELETE_SAFE 0x4
+#define SEM_INVERSION_SAFE 0x8
+SEM_ID semMCreate(int options);
+STATUS semDelete(SEM_ID semaphore);
+
+class Synchronized
+{
+public:
+	Synchronized(SEM_ID semaphore) { (void) semaphore; }
+};
+
+void Wait(double seconds);
+double GetTime(void);
+
+class Timer
+{
+private:
+	double startTime;
+	double accumulated;
+	bool running;
+
+public:
+	Timer(void);
+	double Get(void);
+	void Reset(void);
+	void Start(void);
+	void Stop(void);
+	bool HasPeriodPassed(double period);
+	static double GetFPGATimestamp(void);
+};
+
+typedef void (*TimerEventHandler)(void *param);
+
+class Notifier
+{
+private:
+	TimerEventHandler handler;
+	void *param;
+	double period;
+	double expiration;
+	bool periodic;
+	bool queued;
+	Notifier *next;		//in the list of queued notifiers, soonest first
+
+	void Queue(double when);
+	void Dequeue(void);
+	friend void SimRunNotifiers(double until);
+	friend double SimNextNotifier(double limit);
+
+public:
+	Notifier(TimerEventHandler in_handler, void *in_param = NULL);
+	~Notifier();
+	void StartSingle(double delay);
+	void StartPeriodic(double in_period);
+	void Stop(void);
+};
+
+class MotorSafety
+{
+public:
+	void SetExpiration(double timeout) { (void) timeout; }
+	void SetSafetyEnabled(bool enabled) { (void) enabled; }
+};
+
+class PIDOutput
+{
+public:
+	virtual ~PIDOutput() {}
+	virtual void PIDWrite(float output) = 0;
+};
+
+class PIDSource
+{
+public:
+	virtual ~PIDSource() {}
+	virtual double PIDGet(void) = 0;
+};
+
+class SpeedController : public PIDOutput
+{
+public:
+	virtual void Set(float speed, UINT8 syncGroup = 0) = 0;
+	virtual float Get(void) = 0;
+	virtual void Disable(void) = 0;
+};
+
+class Jaguar : public SpeedController, public MotorSafety
+{
+private:
+	UINT32 channel;
+
+public:
+	explicit Jaguar(UINT32 in_channel);
+	virtual void Set(float speed, UINT8 syncGroup = 0);
+	virtual float Get(void);
+	virtual void Disable(void);
+	virtual void PIDWrite(float output);
+};
+
+class RobotDrive : public MotorSafety
+{
+private:
+	UINT32 leftChannel;
+	UINT32 rightChannel;
+
+public:
+	RobotDrive(UINT32 leftMotorChannel, UINT32 rightMotorChannel);
+	void TankDrive(float leftValue, float rightValue);
+};
+
+class Relay
+{
+public:
+	enum Value { kOff, kOn, kForward, kReverse };
+
+private:
+	UINT32 channel;
+
+public:
+	explicit Relay(UINT32 in_channel);
+	void Set(Value value);
+	Value Get(void);
+};
+
+class DigitalSource
+{
+public:
+	virtual ~DigitalSource() {}
+	virtual UINT32 GetChannel(void) = 0;
+};
+
+class DigitalInput : public DigitalSource
+{
+private:
+	UINT32 channel;
+
+public:
+	explicit DigitalInput(UINT32 in_channel);
+	UINT32 Get(void);
+	UINT32 GetChannel(void) { return channel; }
+};
+
+class Encoder : public PIDSource
+{
+public:
+	enum EncodingType { k1X, k2X, k4X };
+	enum PIDSourceParameter { kDistance, kRate };
+
+private:
+	UINT32 channel;
+	long offset;
+	double distancePerPulse;
+	PIDSourceParameter pidSource;
+
+public:
+	Encoder(DigitalSource &aSource, DigitalSource &bSource, bool reverseDirection = false,
+			EncodingType encodingType = k4X);
+	Encoder(UINT32 aChannel, UINT32 bChannel, bool reverseDirection = false, EncodingType encodingType = k4X);
+	void Start(void) {}
+	void Stop(void) {}
+	void Reset(void);
+	INT32 Get(void);
+	INT32 GetRaw(void) { return Get(); }
+	double GetDistance(void);
+	double GetRate(void);
+	void SetDistancePerPulse(double in_distancePerPulse) { distancePerPulse = in_distancePerPulse; }
+	void SetPIDSourceParameter(PIDSourceParameter in_pidSource) { pidSource = in_pidSource; }
+	double PIDGet(void);
+};
+
+class Joystick
+{
+private:
+	UINT32 port;
+
+public:
+	explicit Joystick(UINT32 in_port);
+	float GetRawAxis(UINT32 axis);
+	bool GetRawButton(UINT32 button);
+};
+
+class SimpleRobot
+{
+public:
+	virtual ~SimpleRobot() {}
+	virtual void Autonomous(void) {}
+	virtual void OperatorControl(void) {}
+	bool IsAutonomous(void);
+	bool IsOperatorControl(void);
+	bool IsEnabled(void);
+	bool IsDisabled(void);
+};
+
+//the robot class is made by the simulation instead of by the robot task
+#define START_ROBOT_CLASS(_ClassName_) \
+	SimpleRobot *CreateRobotInstance(void) \
+	{ \
+		return new _ClassName_(); \
+	}
+
+#endif
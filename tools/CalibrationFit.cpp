@@ -0,0 +1,280 @@
+/**
+ * Fits a VisionCalibration file from samples measured on the field, so recalibrating the camera
+ * and the aim rows means writing down samples and loading the file this makes on the robot.
+ *
+ * Build from the top of the project:
+ *   g++ -O2 -I. -o CalibrationFit tools/CalibrationFit.cpp VisionCalibration.cpp
+ *
+ * Usage:
+ *   CalibrationFit [--image-width N] [--target-width FEET] [--mid-height INCHES] [--out FILE] SAMPLES
+ *
+ * SAMPLES has one high goal per line, taken with the robot where the shot goes in:
+ *
+ *   <width> <height> <row> <distance>
+ *
+ * the goal's width, height and center row in pixels, as the dashboard shows them (highWidth,
+ * highHeight, highY), and the distance to the goal in feet measured on the field. # starts a
+ * comment. tools/CalibrationSamples.txt has the samples the compiled in calibration came from.
+ *
+ * The images are N pixels wide (320 by default). Distance goes as one over the goal's width,
+ * so the camera's view angle comes from a least squares fit of distance to 1/width with the
+ * goal TARGET_WIDTH feet across (5.146 by default). The high goal's height in inches comes from
+ * the same fit to 1/height at that view angle. The middle goal isn't sampled, so its height is
+ * only set by --mid-height (29 by default).
+ *
+ * The aim rows become the table. Samples at the same width are averaged, and since the row
+ * should only move one way as the goal gets wider, any run of samples that goes the other way
+ * is pooled into one point (pool adjacent violators) first. If that leaves more points than a
+ * calibration holds, neighbouring points are averaged together. The calibration is written to
+ * FILE, or stdout, and how well it fits each sample goes to stderr.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include "VisionCalibration.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+struct Sample {
+	double width;
+	double height;
+	double row;
+	double distance;
+};
+
+//a point of the table while it is being fitted, with the number of samples pooled into it
+struct Pool {
+	double width;
+	double row;
+	double weight;
+};
+
+static bool byWidth(const Sample &a, const Sample &b)
+{
+	return a.width < b.width;
+}
+
+static bool readSamples(const char *path, vector<Sample> *samples)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+	{
+		fprintf(stderr, "can't open %s\n", path);
+		return false;
+	}
+	char line[256];
+	int lineNumber = 0;
+	while (fgets(line, sizeof(line), file))
+	{
+		lineNumber++;
+		char *p = line;
+		while (*p == ' ' || *p == '\t')
+			p++;
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0)
+			continue;
+		Sample s;
+		if (sscanf(p, "%lf %lf %lf %lf", &s.width, &s.height, &s.row, &s.distance) != 4
+				|| s.width <= 0 || s.height <= 0 || s.distance <= 0)
+		{
+			fprintf(stderr, "%s:%d: expected \"<width> <height> <row> <distance>\"\n", path, lineNumber);
+			fclose(file);
+			return false;
+		}
+		samples->push_back(s);
+	}
+	fclose(file);
+	return true;
+}
+
+/**
+ * Least squares fit of distance = k / size.
+ */
+static double fitInverse(const vector<Sample> &samples, bool useHeight)
+{
+	double sumDistance = 0, sumInverse = 0;
+	for (unsigned i = 0; i < samples.size(); i++)
+	{
+		double inverse = 1 / (useHeight ? samples[i].height : samples[i].width);
+		sumDistance += samples[i].distance * inverse;
+		sumInverse += inverse * inverse;
+	}
+	return sumDistance / sumInverse;
+}
+
+/**
+ * Averages samples of the same width, then pools neighbours until the rows only ever move in
+ * the direction falling (or rising) is given by.
+ */
+static vector<Pool> fitTable(const vector<Sample> &samples, bool falling)
+{
+	vector<Pool> pools;
+	for (unsigned i = 0; i < samples.size(); i++)
+	{
+		Pool p = { samples[i].width, samples[i].row, 1 };
+		if (!pools.empty() && pools.back().width == p.width)
+		{
+			Pool *last = &pools.back();
+			last->row = (last->row * last->weight + p.row) / (last->weight + 1);
+			last->weight++;
+		}
+		else
+		{
+			pools.push_back(p);
+		}
+		//pool adjacent violators
+		while (pools.size() > 1)
+		{
+			Pool *b = &pools[pools.size() - 1];
+			Pool *a = &pools[pools.size() - 2];
+			if (falling ? a->row > b->row : a->row < b->row)
+				break;
+			double weight = a->weight + b->weight;
+			a->width = (a->width * a->weight + b->width * b->weight) / weight;
+			a->row = (a->row * a->weight + b->row * b->weight) / weight;
+			a->weight = weight;
+			pools.pop_back();
+		}
+	}
+	return pools;
+}
+
+/**
+ * Averages neighbouring points together until there are no more than count of them.
+ */
+static vector<Pool> reduceTable(const vector<Pool> &pools, int count)
+{
+	if ((int) pools.size() <= count)
+		return pools;
+	vector<Pool> reduced;
+	for (int i = 0; i < count; i++)
+	{
+		unsigned first = i * pools.size() / count;
+		unsigned last = (i + 1) * pools.size() / count;
+		Pool p = { 0, 0, 0 };
+		for (unsigned j = first; j < last; j++)
+		{
+			p.width += pools[j].width * pools[j].weight;
+			p.row += pools[j].row * pools[j].weight;
+			p.weight += pools[j].weight;
+		}
+		p.width /= p.weight;
+		p.row /= p.weight;
+		reduced.push_back(p);
+	}
+	return reduced;
+}
+
+int main(int argc, char **argv)
+{
+	int imageWidth = CALIBRATION_IMAGE_WIDTH;
+	double targetWidth = CALIBRATION_TARGET_WIDTH;
+	double midHeight = CALIBRATION_MID_HEIGHT;
+	const char *outPath = NULL;
+	const char *samplesPath = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--image-width") == 0 && i + 1 < argc)
+			imageWidth = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--target-width") == 0 && i + 1 < argc)
+			targetWidth = atof(argv[++i]);
+		else if (strcmp(argv[i], "--mid-height") == 0 && i + 1 < argc)
+			midHeight = atof(argv[++i]);
+		else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+			outPath = argv[++i];
+		else
+			samplesPath = argv[i];
+	}
+	if (!samplesPath || imageWidth <= 0 || targetWidth <= 0)
+	{
+		fprintf(stderr, "usage: %s [--image-width N] [--target-width FEET] [--mid-height INCHES] [--out FILE] SAMPLES\n",
+				argv[0]);
+		return 1;
+	}
+
+	vector<Sample> samples;
+	if (!readSamples(samplesPath, &samples))
+		return 1;
+	stable_sort(samples.begin(), samples.end(), byWidth);
+	if (samples.size() < 2 || samples.front().width == samples.back().width)
+	{
+		fprintf(stderr, "need samples at two or more widths\n");
+		return 1;
+	}
+
+	//focal length in pixels from the widths, which the heights then share
+	double widthConstant = fitInverse(samples, false);
+	double heightConstant = fitInverse(samples, true);
+	double focalLength = widthConstant / targetWidth;
+	double viewAngle = 2 * atan(imageWidth / (2 * focalLength)) * 180 / 3.141592653;
+	double highHeight = 12 * heightConstant / focalLength;
+
+	//which way the rows go, from the least squares slope of row against width
+	double meanWidth = 0, meanRow = 0, covariance = 0;
+	for (unsigned i = 0; i < samples.size(); i++)
+	{
+		meanWidth += samples[i].width / samples.size();
+		meanRow += samples[i].row / samples.size();
+	}
+	for (unsigned i = 0; i < samples.size(); i++)
+		covariance += (samples[i].width - meanWidth) * (samples[i].row - meanRow);
+	vector<Pool> pools = reduceTable(fitTable(samples, covariance < 0), CALIBRATION_MAX_POINTS);
+	if (pools.size() < 2)
+	{
+		fprintf(stderr, "the rows don't change with width, so there is no table to fit\n");
+		return 1;
+	}
+	vector<CalibrationPoint> points(pools.size());
+	for (unsigned i = 0; i < pools.size(); i++)
+	{
+		points[i].width = pools[i].width;
+		points[i].aimY = pools[i].row;
+	}
+
+	VisionCalibration calibration;
+	if (!calibration.Set(imageWidth, viewAngle, targetWidth, highHeight, midHeight, &points[0], points.size()))
+	{
+		fprintf(stderr, "the fit came out of range (view angle %.2f, high goal height %.2f)\n", viewAngle, highHeight);
+		return 1;
+	}
+
+	fprintf(stderr, "%8s %8s %8s %10s %11s %10s %8s\n", "width", "height", "distance", "from width",
+			"from height", "row", "aim row");
+	double widthError = 0, heightError = 0, rowError = 0;
+	for (unsigned i = 0; i < samples.size(); i++)
+	{
+		const Sample &s = samples[i];
+		double fromWidth = calibration.GetDistanceFromWidth(s.width, imageWidth);
+		double fromHeight = calibration.GetDistanceFromHeight(s.height, imageWidth, false);
+		double aimY = calibration.GetAimY(s.width, imageWidth);
+		fprintf(stderr, "%8.1f %8.1f %8.3f %10.3f %11.3f %10.1f %8.1f\n", s.width, s.height, s.distance,
+				fromWidth, fromHeight, s.row, aimY);
+		widthError += (fromWidth - s.distance) * (fromWidth - s.distance);
+		heightError += (fromHeight - s.distance) * (fromHeight - s.distance);
+		rowError += (aimY - s.row) * (aimY - s.row);
+	}
+	fprintf(stderr, "rms error: distance from width %.3f ft, from height %.3f ft, aim row %.2f pixels\n",
+			sqrt(widthError / samples.size()), sqrt(heightError / samples.size()), sqrt(rowError / samples.size()));
+
+	FILE *out = outPath ? fopen(outPath, "w") : stdout;
+	if (!out)
+	{
+		fprintf(stderr, "can't write %s\n", outPath);
+		return 1;
+	}
+	fprintf(out, "# fitted by CalibrationFit from %lu samples in %s\n", (unsigned long) samples.size(), samplesPath);
+	calibration.Write(out);
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,311 @@
+/**
+ * Stands in for the dashboard on a PC: receives the datagrams DashboardPublisher sends, prints
+ * the values in them and measures the bandwidth, loss and latency of the stream.
+ *
+ * Build from the top of the project:
+ *   g++ -O2 -I. -o DashboardReceiver tools/DashboardReceiver.cpp DashboardPublisher.cpp BackgroundTask.cpp -lpthread
+ *
+ * Usage:
+ *   DashboardReceiver [--port N] [--seconds S] [--quiet] [--bench [--rate HZ]]
+ *
+ * Listens on UDP port N (5801 by default) for S seconds (until killed by default). Each value
+ * received is printed as the robot's time, the key name from DashboardKeys.h and the value,
+ * unless --quiet is given. Every second, and at the end, it prints the datagrams, values and
+ * bytes received per second, the datagrams lost (from gaps in the sequence numbers), and the
+ * latency from each Flush() to the datagram arriving (p50, p99, max). The latency is only
+ * meaningful when the robot's clock is this PC's CLOCK_MONOTONIC, which is how --bench runs.
+ * Datagrams sent by the cRIO are big endian and are swapped to the PC's byte order.
+ *
+ * --bench runs a DashboardPublisher in the same process, sending to the port on 127.0.0.1 from
+ * a control loop at HZ (50 by default) that sets the shooter speed every tick and the seven
+ * vision values whenever a simulated 15 Hz camera has a new frame, as OperatorControl does. At
+ * the end it also prints how many values were Set() against how many were sent, which is how
+ * many separate NetworkTables updates the same values used to take.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include "DashboardPublisher.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+//reverses the bytes of a value if the datagram was sent in the other byte order
+static void fix(void *value, int size, bool swapBytes)
+{
+	if (!swapBytes)
+		return;
+	unsigned char *bytes = (unsigned char *) value;
+	for (int i = 0; i < size / 2; i++)
+	{
+		unsigned char b = bytes[i];
+		bytes[i] = bytes[size - 1 - i];
+		bytes[size - 1 - i] = b;
+	}
+}
+
+static double percentile(vector<double> &samples, double fraction)
+{
+	if (samples.empty())
+		return 0;
+	sort(samples.begin(), samples.end());
+	unsigned index = (unsigned) (fraction * (samples.size() - 1) + 0.5);
+	return samples[index];
+}
+
+struct Totals {
+	unsigned long datagrams;
+	unsigned long values;
+	unsigned long bytes;
+	unsigned long lost;
+	vector<double> latencies;
+
+	Totals(void) { Clear(); }
+
+	void Clear(void)
+	{
+		datagrams = 0;
+		values = 0;
+		bytes = 0;
+		lost = 0;
+		latencies.clear();
+	}
+};
+
+static void report(const char *label, Totals *totals, double seconds)
+{
+	double p50 = percentile(totals->latencies, 0.5);
+	double p99 = percentile(totals->latencies, 0.99);
+	double max = percentile(totals->latencies, 1);
+	printf("%s: %.0f datagrams/s, %.0f values/s, %.0f bytes/s, %lu lost, latency ms p50 %.3f p99 %.3f max %.3f\n",
+			label, totals->datagrams / seconds, totals->values / seconds, totals->bytes / seconds, totals->lost,
+			p50 * 1000, p99 * 1000, max * 1000);
+}
+
+/**
+ * Decodes one datagram into the totals, printing its values unless quiet.
+ *
+ * @param lastSequence Sequence number of the last datagram, 0 before the first
+ * @return false if it isn't a dashboard datagram
+ */
+static bool decode(const unsigned char *data, int size, double received, bool quiet, unsigned int *lastSequence,
+		Totals *period, Totals *total)
+{
+	unsigned int magic, sequence;
+	unsigned short version, count;
+	double timestamp;
+	if (size < DASHBOARD_HEADER_SIZE)
+		return false;
+	memcpy(&magic, data, 4);
+	bool swapBytes = magic != DASHBOARD_MAGIC;
+	fix(&magic, 4, swapBytes);
+	if (magic != DASHBOARD_MAGIC)
+		return false;
+	memcpy(&sequence, data + 4, 4);
+	memcpy(&version, data + 8, 2);
+	memcpy(&count, data + 10, 2);
+	memcpy(&timestamp, data + 16, 8);
+	fix(&sequence, 4, swapBytes);
+	fix(&version, 2, swapBytes);
+	fix(&count, 2, swapBytes);
+	fix(&timestamp, 8, swapBytes);
+	if (version != DASHBOARD_VERSION || size < DASHBOARD_HEADER_SIZE + count * DASHBOARD_VALUE_SIZE)
+		return false;
+
+	Totals *totals[2] = { period, total };
+	for (int t = 0; t < 2; t++)
+	{
+		totals[t]->datagrams++;
+		totals[t]->values += count;
+		totals[t]->bytes += size;
+		if (*lastSequence != 0 && sequence > *lastSequence + 1)
+			totals[t]->lost += sequence - *lastSequence - 1;
+		totals[t]->latencies.push_back(received - timestamp);
+	}
+	*lastSequence = sequence;
+
+	const unsigned char *p = data + DASHBOARD_HEADER_SIZE;
+	for (int i = 0; i < count; i++, p += DASHBOARD_VALUE_SIZE)
+	{
+		float value;
+		memcpy(&value, p + 1, 4);
+		fix(&value, 4, swapBytes);
+		if (quiet)
+			continue;
+		if (p[0] < DASHBOARD_KEY_COUNT)
+			printf("%12.6f  %-16s %g\n", timestamp, dashboardKeys[p[0]].name, value);
+		else
+			printf("%12.6f  key%-13d %g\n", timestamp, p[0], value);
+	}
+	return true;
+}
+
+/**
+ * The --bench robot: a control loop setting values the way OperatorControl does.
+ */
+struct Bench {
+	DashboardPublisher *publisher;
+	double rate;
+	double seconds;
+	unsigned long valuesSet;
+	volatile bool done;
+};
+
+static void *runBench(void *arg)
+{
+	Bench *bench = (Bench *) arg;
+	double start = now();
+	double period = 1 / bench->rate;
+	unsigned long frame = 0;
+	bool goal = false;
+	for (unsigned long tick = 0; ; tick++)
+	{
+		double next = start + (tick + 1) * period;
+		double t = now() - start;
+		if (t >= bench->seconds)
+			break;
+		double speed = 300 * (1 - exp(-t)) + (rand() % 7 - 3);
+		bench->publisher->Set(DASHBOARD_SPEED, speed);
+		bench->valuesSet++;
+		if ((unsigned long) (t * 15) != frame)
+		{
+			frame = (unsigned long) (t * 15);
+			if (frame % 45 == 0)
+				goal = !goal;
+			double width = 80 + 40 * sin(t / 3);
+			bench->publisher->Set(DASHBOARD_HIGH_GOAL, goal ? 1 : 0);
+			bench->valuesSet++;
+			if (goal)
+			{
+				bench->publisher->Set(DASHBOARD_HIGH_DISTANCE, 2064 / width);
+				bench->publisher->Set(DASHBOARD_HIGH_X, 160 + (int) (20 * sin(t)));
+				bench->publisher->Set(DASHBOARD_HIGH_Y, 150 + (int) (30 * cos(t / 2)));
+				bench->publisher->Set(DASHBOARD_HIGH_WIDTH, (int) width);
+				bench->publisher->Set(DASHBOARD_HIGH_HEIGHT, (int) (width / 3));
+				bench->publisher->Set(DASHBOARD_AIM_Y, 240 - (int) (width / 2));
+				bench->valuesSet += 6;
+			}
+		}
+		bench->publisher->Flush();
+		double wait = next - now();
+		if (wait > 0)
+		{
+			struct timespec delay;
+			delay.tv_sec = (time_t) wait;
+			delay.tv_nsec = (long) ((wait - delay.tv_sec) * 1e9);
+			nanosleep(&delay, NULL);
+		}
+	}
+	bench->done = true;
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	int port = 5801;
+	double seconds = 0;
+	bool quiet = false;
+	bool bench = false;
+	double rate = 50;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+			port = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			seconds = atof(argv[++i]);
+		else if (strcmp(argv[i], "--quiet") == 0)
+			quiet = true;
+		else if (strcmp(argv[i], "--bench") == 0)
+			bench = true;
+		else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc)
+			rate = atof(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: %s [--port N] [--seconds S] [--quiet] [--bench [--rate HZ]]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (bench && seconds <= 0)
+		seconds = 10;
+
+	int s = socket(AF_INET, SOCK_DGRAM, 0);
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (s < 0 || bind(s, (struct sockaddr *) &address, sizeof(address)) != 0)
+	{
+		fprintf(stderr, "can't listen on port %d\n", port);
+		return 1;
+	}
+	struct timeval timeout = { 0, 100000 };
+	setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	DashboardPublisher publisher(now);
+	Bench benchState = { &publisher, rate, seconds, 0, false };
+	pthread_t benchThread;
+	if (bench)
+	{
+		if (!publisher.Start("127.0.0.1", port) || pthread_create(&benchThread, NULL, runBench, &benchState) != 0)
+		{
+			fprintf(stderr, "can't start the bench publisher\n");
+			return 1;
+		}
+	}
+
+	Totals period, total;
+	unsigned int lastSequence = 0;
+	double started = now();
+	double periodStart = started;
+	for (;;)
+	{
+		unsigned char data[2048];
+		int size = recv(s, data, sizeof(data), 0);
+		double received = now();
+		if (size > 0 && !decode(data, size, received, quiet, &lastSequence, &period, &total))
+			fprintf(stderr, "ignoring a %d byte datagram that isn't from DashboardPublisher\n", size);
+		if (received - periodStart >= 1)
+		{
+			report("last second", &period, received - periodStart);
+			period.Clear();
+			periodStart = received;
+		}
+		if (seconds > 0 && received - started >= seconds && (!bench || benchState.done))
+			break;
+	}
+	report("overall", &total, now() - started);
+
+	if (bench)
+	{
+		pthread_join(benchThread, NULL);
+		publisher.Stop();
+		printf("bench: %lu values set in %.0f ticks, %lu sent in %lu datagrams (%lu bytes), %lu dropped\n",
+				benchState.valuesSet, seconds * rate, total.values, publisher.GetSentCount(),
+				publisher.GetBytesSent(), publisher.GetDroppedCount());
+	}
+	close(s);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,318 @@
+/**
+ * Tunes the shooter on a PC: runs the shooter's speed estimate and controller against a
+ * FlywheelSim for every combination of gains and ready thresholds in a grid, on all cores, and
+ * ranks them by how quickly they get a string of discs away without overshooting or firing off
+ * speed.
+ *
+ * Build from the top of the project:
+ *   g++ -O2 -I. -o FlywheelTune tools/FlywheelTune.cpp FlywheelSim.cpp FlywheelSpeed.cpp \
+ *       FlywheelController.cpp -lpthread
+ *
+ * Usage:
+ *   FlywheelTune [--threads N] [--shots N] [--setpoint S] [--top N] [--csv FILE]
+ *
+ * Each combination spins the flywheel up from rest to S counts/s (WHEELSPEED, by default)
+ * and fires N discs (4 by default), each as soon as the robot's ready check would allow:
+ * the estimated speed inside the band for the settle time, with the count only starting over
+ * when the speed drops under the minimum, as in MyRobot.cpp. The controller runs every 10 ms
+ * with a little timing jitter and the ready check every 20 ms, like on the robot. Every
+ * combination is run on a fresh battery and on a tired one (11 V), and scored on the worse of
+ * the two:
+ *
+ *   score = time to the last shot + 0.02 s per count/s of speed error at each shot
+ *           + 0.01 s per count/s of overshoot
+ *
+ * The best N (10 by default) are printed with their spin-up time, mean time between shots,
+ * overshoot and speed error at the shot, followed by the defines for the best one: the speed
+ * limits go in ShotSettings.h and the gains in MyRobot.cpp.
+ * --csv writes every combination.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include "FlywheelSim.h"
+#include "FlywheelSpeed.h"
+#include "FlywheelController.h"
+#include "ShotSettings.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+//Matches MyRobot.cpp
+#define CONTROL_PERIOD 0.01			//SHOOTERPERIOD
+#define CHECK_PERIOD 0.02			//CONTROLPERIOD, the ready check runs in the control loop
+#define SPEED_WINDOW_TICKS 10		//SHOOTERSPEEDWINDOW
+#define MAX_OUTPUT 0.99				//PIDJaguar's clamp
+#define TIME_LIMIT 15.0				//seconds before a combination that can't get its shots away gives up
+#define JITTER 0.0005				//most the controller's period varies by, in seconds
+
+//Score weights, in seconds per count/s
+#define FIRE_ERROR_WEIGHT 0.02
+#define OVERSHOOT_WEIGHT 0.01
+
+struct Candidate {
+	double kP, kI, kV, kS;
+	double bangBangBand;		//0 for off
+	double readyBand;			//LOWERTHRESHOLD and UPPERTHRESHOLD are this far either side
+	double minimumOffset;		//MINIMUMSPEED is this far under the setpoint
+	double settleTime;			//seconds in the band before firing
+};
+
+struct Outcome {
+	bool completed;
+	double spinUp;			//seconds to the first shot
+	double recovery;		//mean seconds between shots
+	double lastShot;
+	double overshoot;		//most the real speed went over the setpoint, in counts/s
+	double fireError;		//mean distance of the real speed from the setpoint at each shot
+	double score;
+};
+
+struct Result {
+	Candidate candidate;
+	Outcome outcome;
+};
+
+static bool betterResult(const Result &a, const Result &b)
+{
+	return a.outcome.score < b.outcome.score;
+}
+
+//small generator so every run sees the same jitter no matter which thread runs it
+static double nextRandom(unsigned long *state)
+{
+	*state = *state * 1103515245UL + 12345UL;
+	return ((*state >> 16) & 0x7fff) / 32768.0;
+}
+
+static Outcome simulate(const Candidate &c, const FlywheelSimParameters &plant, double setpoint, int shots)
+{
+	FlywheelSim sim(plant);
+	FlywheelSpeed speed(SPEED_WINDOW_TICKS);
+	FlywheelController controller(c.kP, c.kI, 0, c.kV, c.kS);
+	controller.SetOutputRange(0, MAX_OUTPUT);
+	controller.SetInverted(true);
+	controller.SetSetpoint(setpoint);
+	controller.SetBangBang(c.bangBangBand > 0, c.bangBangBand);
+
+	Outcome outcome;
+	outcome.completed = false;
+	outcome.spinUp = 0;
+	outcome.overshoot = 0;
+	outcome.fireError = 0;
+	outcome.lastShot = 0;
+	unsigned long seed = 1;
+	int settleChecks = (int) ceil(c.settleTime / CHECK_PERIOD - 1e-9);
+	int goodCount = 0;
+	int fired = 0;
+	bool reached = false;
+	double nextCheck = CHECK_PERIOD;
+
+	while (sim.GetTime() < TIME_LIMIT && fired < shots)
+	{
+		double dt = CONTROL_PERIOD + (nextRandom(&seed) * 2 - 1) * JITTER;
+		sim.Step(dt);
+		double now = sim.GetTime();
+		speed.Update(sim.GetCount(), now);
+		sim.SetCommand(controller.Calculate(speed.GetSpeed(), dt));
+
+		double actual = sim.GetSpeed();
+		if (actual >= setpoint)
+			reached = true;
+		if (reached && !sim.IsShooting() && actual - setpoint > outcome.overshoot)
+			outcome.overshoot = actual - setpoint;
+
+		if (now < nextCheck)
+			continue;
+		nextCheck += CHECK_PERIOD;
+		double estimate = speed.GetSpeed();
+		if (estimate >= setpoint - c.readyBand && estimate <= setpoint + c.readyBand)
+			goodCount++;
+		else if (estimate < setpoint - c.minimumOffset)
+			goodCount = 0;
+		if (goodCount >= settleChecks && !sim.IsShooting())
+		{
+			if (fired == 0)
+				outcome.spinUp = now;
+			outcome.fireError += fabs(actual - setpoint);
+			outcome.lastShot = now;
+			sim.FireDisc();
+			reached = false;
+			goodCount = 0;
+			fired++;
+		}
+	}
+	outcome.completed = fired == shots;
+	outcome.fireError = fired ? outcome.fireError / fired : 0;
+	outcome.recovery = fired > 1 ? (outcome.lastShot - outcome.spinUp) / (fired - 1) : 0;
+	if (outcome.completed)
+		outcome.score = outcome.lastShot + FIRE_ERROR_WEIGHT * outcome.fireError * shots
+				+ OVERSHOOT_WEIGHT * outcome.overshoot;
+	else
+		outcome.score = 1e9 - fired;
+	return outcome;
+}
+
+struct Sweep {
+	vector<Result> *results;
+	vector<FlywheelSimParameters> plants;
+	double setpoint;
+	int shots;
+	int threads;
+	int index;
+};
+
+static void *runSweep(void *arg)
+{
+	Sweep *sweep = (Sweep *) arg;
+	vector<Result> &results = *sweep->results;
+	for (unsigned i = sweep->index; i < results.size(); i += sweep->threads)
+	{
+		Outcome worst;
+		for (unsigned p = 0; p < sweep->plants.size(); p++)
+		{
+			Outcome outcome = simulate(results[i].candidate, sweep->plants[p], sweep->setpoint, sweep->shots);
+			if (p == 0 || outcome.score > worst.score)
+				worst = outcome;
+		}
+		results[i].outcome = worst;
+	}
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	int threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	int shots = 4;
+	double setpoint = WHEELSPEED;
+	int top = 10;
+	const char *csvPath = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--shots") == 0 && i + 1 < argc)
+			shots = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--setpoint") == 0 && i + 1 < argc)
+			setpoint = atof(argv[++i]);
+		else if (strcmp(argv[i], "--top") == 0 && i + 1 < argc)
+			top = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+			csvPath = argv[++i];
+		else
+		{
+			fprintf(stderr, "usage: %s [--threads N] [--shots N] [--setpoint S] [--top N] [--csv FILE]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (threads < 1)
+		threads = 1;
+
+	FlywheelSimParameters fresh = FlywheelSim::DefaultParameters();
+	FlywheelSimParameters tired = fresh;
+	tired.batteryVoltage = 11;
+
+	static const double kPs[] = { 0.005, 0.01, 0.02, 0.04 };
+	static const double kIs[] = { 0, 0.02, 0.05, 0.1 };
+	static const double kVScales[] = { 0.9, 1.0, 1.1 };
+	static const double kSs[] = { 0, 0.05 };
+	static const double bangBangBands[] = { 0, 10, 20, 40 };
+	static const double readyBands[] = { 5, 10, 15 };
+	static const double minimumOffsets[] = { 25, 50 };
+	static const double settleTimes[] = { 0.06, 0.1, 0.16, 0.24 };
+#define COUNT(a) (sizeof(a) / sizeof((a)[0]))
+
+	vector<Result> results;
+	for (unsigned a = 0; a < COUNT(kPs); a++)
+	for (unsigned b = 0; b < COUNT(kIs); b++)
+	for (unsigned v = 0; v < COUNT(kVScales); v++)
+	for (unsigned s = 0; s < COUNT(kSs); s++)
+	for (unsigned g = 0; g < COUNT(bangBangBands); g++)
+	for (unsigned r = 0; r < COUNT(readyBands); r++)
+	for (unsigned m = 0; m < COUNT(minimumOffsets); m++)
+	for (unsigned t = 0; t < COUNT(settleTimes); t++)
+	{
+		Result result;
+		result.candidate.kP = kPs[a];
+		result.candidate.kI = kIs[b];
+		result.candidate.kV = kVScales[v] / fresh.freeSpeed;
+		result.candidate.kS = kSs[s];
+		result.candidate.bangBangBand = bangBangBands[g];
+		result.candidate.readyBand = readyBands[r];
+		result.candidate.minimumOffset = minimumOffsets[m];
+		result.candidate.settleTime = settleTimes[t];
+		results.push_back(result);
+	}
+
+	vector<Sweep> sweeps(threads);
+	vector<pthread_t> ids(threads);
+	for (int i = 0; i < threads; i++)
+	{
+		sweeps[i].results = &results;
+		sweeps[i].plants.push_back(fresh);
+		sweeps[i].plants.push_back(tired);
+		sweeps[i].setpoint = setpoint;
+		sweeps[i].shots = shots;
+		sweeps[i].threads = threads;
+		sweeps[i].index = i;
+		pthread_create(&ids[i], NULL, runSweep, &sweeps[i]);
+	}
+	for (int i = 0; i < threads; i++)
+		pthread_join(ids[i], NULL);
+	sort(results.begin(), results.end(), betterResult);
+
+	if (csvPath)
+	{
+		FILE *csv = fopen(csvPath, "w");
+		if (!csv)
+		{
+			fprintf(stderr, "can't write %s\n", csvPath);
+			return 1;
+		}
+		fprintf(csv, "kP,kI,kV,kS,bangBangBand,readyBand,minimumOffset,settleTime,"
+				"completed,spinUp,recovery,overshoot,fireError,score\n");
+		for (unsigned i = 0; i < results.size(); i++)
+		{
+			const Candidate &c = results[i].candidate;
+			const Outcome &o = results[i].outcome;
+			fprintf(csv, "%g,%g,%g,%g,%g,%g,%g,%g,%d,%.3f,%.3f,%.1f,%.1f,%.3f\n", c.kP, c.kI, c.kV, c.kS,
+					c.bangBangBand, c.readyBand, c.minimumOffset, c.settleTime, o.completed, o.spinUp,
+					o.recovery, o.overshoot, o.fireError, o.score);
+		}
+		fclose(csv);
+	}
+
+	fprintf(stderr, "%u combinations x %u plants on %d threads\n", (unsigned) results.size(), 2, threads);
+	printf("%4s %7s %7s %7s %6s %6s  %6s %5s %7s %5s %4s %4s %4s %6s\n", "rank", "score", "spinup", "between",
+			"over", "error", "kP", "kI", "kV", "kS", "bang", "band", "min", "settle");
+	for (int i = 0; i < top && i < (int) results.size(); i++)
+	{
+		const Candidate &c = results[i].candidate;
+		const Outcome &o = results[i].outcome;
+		printf("%4d %7.3f %7.3f %7.3f %6.1f %6.1f  %6g %5g %7.5f %5g %4g %4g %4g %6g\n", i + 1, o.score, o.spinUp,
+				o.recovery, o.overshoot, o.fireError, c.kP, c.kI, c.kV, c.kS, c.bangBangBand, c.readyBand,
+				c.minimumOffset, c.settleTime);
+	}
+
+	const Candidate &best = results[0].candidate;
+	printf("\n#define LOWERTHRESHOLD (WHEELSPEED-%g)\n", best.readyBand);
+	printf("#define UPPERTHRESHOLD (WHEELSPEED+%g)\n", best.readyBand);
+	printf("#define MINIMUMSPEED (WHEELSPEED-%g)\n", best.minimumOffset);
+	printf("#define SPEEDSETTLETIME %g\n", best.settleTime);
+	printf("#define SHOOTERKP %g\n#define SHOOTERKI %g\n#define SHOOTERKV %g\n#define SHOOTERKS %g\n", best.kP,
+			best.kI, best.kV, best.kS);
+	printf("#define SHOOTERBANGBAND %g\n", best.bangBangBand);
+	return 0;
+}
+
+#endif
@@ -0,0 +1,237 @@
+/**
+ * Stands in for the Axis camera on a PC: serves saved camera frames as an MJPEG stream the same
+ * way the camera serves /mjpg/video.mjpg, so MjpegStream and the vision code can be run without
+ * a camera.
+ *
+ * Build from the top of the project:
+ *   g++ -O2 -o MjpegServer tools/MjpegServer.cpp -lpthread
+ *
+ * Usage:
+ *   MjpegServer [--port N] [--fps R] DIR_OR_JPEG...
+ *
+ * Listens on port N (8080 by default) and sends every client the JPEGs in name order, over and
+ * over, at R frames per second (30 by default). Any path is answered with the stream. Each part
+ * has a Content-Type and Content-Length header like the camera sends. Frames are sent on a fixed
+ * schedule, so a client that reads too slowly falls behind and gets frames late, the same as
+ * with the real camera.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <signal.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+#define BOUNDARY "myboundary"
+
+struct Frame {
+	string header;		//boundary line and part headers
+	vector<unsigned char> jpeg;
+};
+
+static vector<Frame> frames;
+static double framePeriod;
+
+static bool hasJpegExtension(const string &name)
+{
+	size_t dot = name.rfind('.');
+	if (dot == string::npos)
+		return false;
+	string ext = name.substr(dot + 1);
+	return strcasecmp(ext.c_str(), "jpg") == 0 || strcasecmp(ext.c_str(), "jpeg") == 0;
+}
+
+static bool readFile(const string &path, vector<unsigned char> *data)
+{
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp)
+		return false;
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data->resize(size);
+	bool ok = size > 0 && fread(&(*data)[0], 1, size, fp) == (size_t) size;
+	fclose(fp);
+	return ok;
+}
+
+/**
+ * Adds a JPEG file, or every JPEG in a directory in name order, to the frames.
+ */
+static void addFrames(const string &path)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		fprintf(stderr, "can't read %s\n", path.c_str());
+		return;
+	}
+	vector<string> files;
+	if (S_ISDIR(info.st_mode))
+	{
+		DIR *dir = opendir(path.c_str());
+		struct dirent *entry;
+		while (dir && (entry = readdir(dir)) != NULL)
+		{
+			if (hasJpegExtension(entry->d_name))
+				files.push_back(path + "/" + entry->d_name);
+		}
+		if (dir)
+			closedir(dir);
+		sort(files.begin(), files.end());
+	}
+	else
+	{
+		files.push_back(path);
+	}
+	for (unsigned i = 0; i < files.size(); i++)
+	{
+		Frame frame;
+		if (!readFile(files[i], &frame.jpeg))
+		{
+			fprintf(stderr, "can't read %s\n", files[i].c_str());
+			continue;
+		}
+		char header[128];
+		sprintf(header, "--" BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %lu\r\n\r\n",
+				(unsigned long) frame.jpeg.size());
+		frame.header = header;
+		frames.push_back(frame);
+	}
+}
+
+static bool sendAll(int fd, const void *data, size_t size)
+{
+	const char *p = (const char *) data;
+	while (size > 0)
+	{
+		ssize_t n = send(fd, p, size, MSG_NOSIGNAL);
+		if (n <= 0)
+			return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+/**
+ * Reads the request, then streams frames until the client goes away.
+ */
+static void *serveClient(void *arg)
+{
+	int fd = (int) (long) arg;
+	char request[2048];
+	int used = 0;
+	while (used < (int) sizeof(request) - 1)
+	{
+		ssize_t n = recv(fd, request + used, sizeof(request) - 1 - used, 0);
+		if (n <= 0)
+			break;
+		used += n;
+		request[used] = 0;
+		if (strstr(request, "\r\n\r\n"))
+			break;
+	}
+	request[used] = 0;
+	if (!strstr(request, "\r\n\r\n"))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	static const char response[] = "HTTP/1.0 200 OK\r\n"
+			"Cache-Control: no-cache\r\n"
+			"Content-Type: multipart/x-mixed-replace; boundary=" BOUNDARY "\r\n\r\n";
+	bool ok = sendAll(fd, response, sizeof(response) - 1);
+
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (unsigned i = 0; ok; i = (i + 1) % frames.size())
+	{
+		const Frame &frame = frames[i];
+		ok = sendAll(fd, frame.header.data(), frame.header.size())
+				&& sendAll(fd, &frame.jpeg[0], frame.jpeg.size())
+				&& sendAll(fd, "\r\n", 2);
+
+		//absolute deadlines, so the rate doesn't drift with the time spent sending
+		long period = (long) (framePeriod * 1e9);
+		next.tv_nsec += period % 1000000000L;
+		next.tv_sec += period / 1000000000L + next.tv_nsec / 1000000000L;
+		next.tv_nsec %= 1000000000L;
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	close(fd);
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	int port = 8080;
+	double fps = 30;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+			port = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+			fps = atof(argv[++i]);
+		else
+			addFrames(argv[i]);
+	}
+	if (frames.empty() || fps <= 0 || port <= 0)
+	{
+		fprintf(stderr, "usage: %s [--port N] [--fps R] DIR_OR_JPEG...\n", argv[0]);
+		return 1;
+	}
+	framePeriod = 1 / fps;
+	signal(SIGPIPE, SIG_IGN);
+
+	int listener = socket(AF_INET, SOCK_STREAM, 0);
+	int on = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (listener < 0 || bind(listener, (struct sockaddr *) &address, sizeof(address)) != 0
+			|| listen(listener, 4) != 0)
+	{
+		fprintf(stderr, "can't listen on port %d\n", port);
+		return 1;
+	}
+	fprintf(stderr, "serving %u frames on port %d at %.1f frames/s\n", (unsigned) frames.size(), port, fps);
+
+	for (;;)
+	{
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0)
+			continue;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, serveClient, (void *) (long) fd) == 0)
+			pthread_detach(thread);
+		else
+			close(fd);
+	}
+	return 0;
+}
+
+#endif
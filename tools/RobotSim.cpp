@@ -0,0 +1,234 @@
+/**
+ * Runs MyRobot.cpp on a PC against the simulated robot in sim/, in virtual time, to measure how
+ * long the autonomous routine takes to get its discs away and to catch changes that slow it down.
+ *
+ * Build from the top of the project (sim/ has to come first on the include path, so the robot
+ * code gets the simulated WPILib.h):
+ *   g++ -O2 -Isim -I. -o RobotSim tools/RobotSim.cpp sim/Simulation.cpp MyRobot.cpp \
+ *       FlywheelSim.cpp FlywheelSpeed.cpp FlywheelController.cpp FlywheelControlLoop.cpp \
+ *       HurricaneFeed.cpp ShotSequencer.cpp ShotReadiness.cpp ShooterAngleEstimator.cpp \
+ *       VisionCalibration.cpp PeriodicLoop.cpp TimeHistogram.cpp TelemetryLog.cpp DashboardPublisher.cpp \
+ *       BackgroundTask.cpp -lpthread
+ *
+ * Usage:
+ *   RobotSim [--runs N] [--discs N] [--voltage V] [--limit S] [--teleop SCRIPT SECONDS] [--verbose]
+ *
+ * The robot is made once, as on the cRIO, and runs the 15 second autonomous period N times (1000
+ * by default), each after a second disabled with the simulation reset and N discs (8 by default)
+ * loaded. The battery is at V volts (12 by default). It prints the time of each shot in the first
+ * run, then across all the runs the time to the first shot, the time between shots and the time
+ * to the last one, how far the flywheel was from WHEELSPEED as each disc went in, and how many
+ * runs of the real robot code it managed per second of wall time.
+ * With --limit it exits with status 1 if any run took longer than S seconds to get all its discs
+ * away, or didn't. --teleop plays a joystick script (see SimLoadScript() in sim/Simulation.cpp)
+ * through a teleop period of the given length afterwards and prints the shots it made and where
+ * the shooter angle finished.
+ *
+ * The robot's own console output, such as the loop statistics, is thrown away unless --verbose
+ * is given. The robot writes its telemetry to telemetry.bin in the current directory, for
+ * tools/TelemetryDecode, and sends its dashboard values to 127.0.0.1.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include "WPILib.h"
+#include "Simulation.h"
+#include "ShotSettings.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+#define AUTONOMOUS_TIME 15.0
+#define DISABLED_TIME 1.0	//seconds disabled before each run, long enough for the speed estimate to settle at 0
+
+SimpleRobot *CreateRobotInstance(void);
+
+static double WallTime(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static double Percentile(vector<double> values, double p)
+{
+	if (values.empty())
+		return 0;
+	sort(values.begin(), values.end());
+	return values[(size_t) (p * (values.size() - 1) + 0.5)];
+}
+
+static void PrintSummary(const char *name, const vector<double> &values)
+{
+	if (values.empty())
+	{
+		printf("%-22s      -\n", name);
+		return;
+	}
+	printf("%-22s %6.3f %6.3f %6.3f %6.3f\n", name, Percentile(values, 0), Percentile(values, 0.5),
+			Percentile(values, 0.99), Percentile(values, 1));
+}
+
+/**
+ * Sends stdout to /dev/null while the robot is running, or puts it back.
+ */
+static int HideOutput(bool hide, int saved)
+{
+	fflush(stdout);
+	if (hide)
+	{
+		saved = dup(1);
+		int null = open("/dev/null", O_WRONLY);
+		dup2(null, 1);
+		close(null);
+		return saved;
+	}
+	dup2(saved, 1);
+	close(saved);
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	int runs = 1000;
+	int discs = 8;
+	double voltage = 12;
+	double limit = 0;
+	const char *scriptPath = NULL;
+	double teleopTime = 0;
+	bool verbose = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc)
+			runs = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--discs") == 0 && i + 1 < argc)
+			discs = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--voltage") == 0 && i + 1 < argc)
+			voltage = atof(argv[++i]);
+		else if (strcmp(argv[i], "--limit") == 0 && i + 1 < argc)
+			limit = atof(argv[++i]);
+		else if (strcmp(argv[i], "--teleop") == 0 && i + 2 < argc)
+		{
+			scriptPath = argv[++i];
+			teleopTime = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--verbose") == 0)
+			verbose = true;
+		else
+		{
+			fprintf(stderr, "usage: %s [--runs N] [--discs N] [--voltage V] [--limit S] "
+					"[--teleop SCRIPT SECONDS] [--verbose]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (runs < 1)
+		runs = 1;
+
+	SimParameters parameters = SimDefaultParameters();
+	parameters.discs = discs;
+	parameters.shooter.batteryVoltage = voltage;
+	SimReset(parameters);
+
+	int saved = verbose ? -1 : HideOutput(true, -1);
+	SimpleRobot *robot = CreateRobotInstance();
+
+	vector<double> firstShots, cycles, lastShots, speedErrors;
+	vector<SimShot> firstRun;
+	int slowRuns = 0;
+	int fewestShots = SIM_MAX_SHOTS;
+	double start = WallTime();
+	for (int run = 0; run < runs; run++)
+	{
+		SimReset(parameters);
+		SimAdvance(DISABLED_TIME);
+		SimStartMode(SIM_AUTONOMOUS, AUTONOMOUS_TIME);
+		robot->Autonomous();
+
+		SimShot shots[SIM_MAX_SHOTS];
+		int count = min(SimGetShots(shots, SIM_MAX_SHOTS), SIM_MAX_SHOTS);
+		double modeStart = SimGetModeStart();
+		if (run == 0)
+		{
+			firstRun.assign(shots, shots + count);
+			for (int i = 0; i < count; i++)
+				firstRun[i].time -= modeStart;
+		}
+		fewestShots = min(fewestShots, count);
+		if (count > 0)
+		{
+			firstShots.push_back(shots[0].time - modeStart);
+			lastShots.push_back(shots[count - 1].time - modeStart);
+		}
+		for (int i = 1; i < count; i++)
+			cycles.push_back(shots[i].time - shots[i - 1].time);
+		for (int i = 0; i < count; i++)
+			speedErrors.push_back(shots[i].speed - WHEELSPEED);
+		if (limit > 0 && (count < discs || shots[count - 1].time - modeStart > limit))
+			slowRuns++;
+	}
+	double elapsed = WallTime() - start;
+
+	SimShot teleopShots[SIM_MAX_SHOTS];
+	int teleopCount = 0;
+	double teleopStart = 0;
+	double teleopAngle = 0;
+	if (scriptPath)
+	{
+		if (!SimLoadScript(scriptPath))
+		{
+			if (!verbose)
+				HideOutput(false, saved);
+			fprintf(stderr, "can't load %s\n", scriptPath);
+			return 1;
+		}
+		SimReset(parameters);
+		SimAdvance(DISABLED_TIME);
+		SimStartMode(SIM_TELEOP, teleopTime);
+		robot->OperatorControl();
+		teleopStart = SimGetModeStart();
+		teleopCount = min(SimGetShots(teleopShots, SIM_MAX_SHOTS), SIM_MAX_SHOTS);
+		teleopAngle = SimGetAnglePosition();
+	}
+	delete robot;
+	if (!verbose)
+		HideOutput(false, saved);
+
+	printf("first run, %d discs at %.1f V:\n", discs, voltage);
+	printf("  shot   time  speed\n");
+	for (size_t i = 0; i < firstRun.size(); i++)
+		printf("  %4d %6.3f %6.1f\n", (int) i + 1, firstRun[i].time, firstRun[i].speed);
+	printf("\n%d runs, %.2f s, %.0f runs/s (%.0fx real time), fewest shots %d\n", runs, elapsed,
+			runs / elapsed, runs * (AUTONOMOUS_TIME + DISABLED_TIME) / elapsed, fewestShots);
+	printf("%-22s %6s %6s %6s %6s\n", "", "min", "p50", "p99", "max");
+	PrintSummary("first shot, s", firstShots);
+	PrintSummary("between shots, s", cycles);
+	PrintSummary("last shot, s", lastShots);
+	PrintSummary("speed error, counts/s", speedErrors);
+
+	if (scriptPath)
+	{
+		printf("\nteleop, %s for %.1f s: %d shots, shooter angle %.3f at the end\n", scriptPath, teleopTime,
+				teleopCount, teleopAngle);
+		for (int i = 0; i < teleopCount; i++)
+			printf("  %4d %6.3f %6.1f\n", i + 1, teleopShots[i].time - teleopStart, teleopShots[i].speed);
+	}
+
+	if (slowRuns > 0)
+	{
+		printf("\n%d of %d runs didn't get %d discs away within %.2f s\n", slowRuns, runs, discs, limit);
+		return 1;
+	}
+	return 0;
+}
+
+#endif
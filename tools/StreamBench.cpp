@@ -0,0 +1,153 @@
+/**
+ * Reads an MJPEG stream with MjpegStream and runs the vision pipeline on the newest frame over
+ * and over, the way Vision2823 does on the robot, then reports how many frames came in, how many
+ * were dropped for newer ones, and how old each frame was by the time it was processed.
+ *
+ * Build from the top of the project:
+ *   g++ -O2 -I. -o StreamBench tools/StreamBench.cpp MjpegStream.cpp HSVThreshold.cpp ParticleLabeler.cpp \
+ *       VisionPipeline.cpp YCbCrThreshold.cpp JpegFrameDecoder.cpp VisionCalibration.cpp BackgroundTask.cpp \
+ *       -ljpeg -lpthread
+ *
+ * Usage:
+ *   StreamBench [--host H] [--port N] [--path P] [--seconds S] [--scale N] [--ycbcr] [--work MS]
+ *
+ * Connects to H:N (127.0.0.1:8080 by default, where tools/MjpegServer listens) and runs for S
+ * seconds (10 by default). --scale and --ycbcr decode the frames the same way as in VisionReplay.
+ * --work adds MS milliseconds of busy waiting to every frame to stand in for a slower processor,
+ * which shows frames being dropped instead of queueing up. Frame age is measured from when the
+ * last byte of the frame arrived to when the pipeline finished with it.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include "MjpegStream.h"
+#include "VisionPipeline.h"
+#include "JpegFrameDecoder.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static double percentile(vector<double> &samples, double fraction)
+{
+	if (samples.empty())
+		return 0;
+	unsigned index = (unsigned) (fraction * (samples.size() - 1) + 0.5);
+	nth_element(samples.begin(), samples.begin() + index, samples.end());
+	return samples[index];
+}
+
+int main(int argc, char **argv)
+{
+	const char *host = "127.0.0.1";
+	int port = 8080;
+	const char *path = "/mjpg/video.mjpg";
+	double seconds = 10;
+	int scale = 1;
+	bool ycbcr = false;
+	double work = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--host") == 0 && i + 1 < argc)
+			host = argv[++i];
+		else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+			port = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--path") == 0 && i + 1 < argc)
+			path = argv[++i];
+		else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+			seconds = atof(argv[++i]);
+		else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+			scale = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--ycbcr") == 0)
+			ycbcr = true;
+		else if (strcmp(argv[i], "--work") == 0 && i + 1 < argc)
+			work = atof(argv[++i]) / 1000;
+		else
+		{
+			fprintf(stderr, "usage: %s [--host H] [--port N] [--path P] [--seconds S] [--scale N] [--ycbcr] "
+					"[--work MS]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	VisionPipeline pipeline;
+	VisionFrame *frame = new VisionFrame();
+	JpegFrameDecoder decoder(MAX_IMAGE_WIDTH, MAX_IMAGE_HEIGHT);
+	YCbCrThreshold *ycbcrThreshold = ycbcr ? new YCbCrThreshold(pipeline.GetThreshold()) : NULL;
+	int pixelStride = MAX_IMAGE_WIDTH * 4;
+	vector<unsigned char> pixels(MAX_IMAGE_WIDTH * MAX_IMAGE_HEIGHT * 4);
+	vector<double> ages;
+	pipeline.SetYCbCrThreshold(ycbcrThreshold);
+	decoder.SetScale(scale);
+	decoder.SetFormat(ycbcr ? JPEG_PIXELS_YCBCR : JPEG_PIXELS_BGRA);
+
+	MjpegStream stream(host, port, path, now);
+	if (!stream.Start())
+	{
+		fprintf(stderr, "can't find %s, or can't start the stream's task\n", host);
+		return 1;
+	}
+
+	//the first frame shows the connection works, and starts the clock
+	MjpegFrame jpeg;
+	if (!stream.WaitForFrame(&jpeg))
+		return 1;
+	unsigned long firstReceived = stream.GetReceivedCount() - 1;
+	unsigned long firstDropped = stream.GetDroppedCount();
+	unsigned long firstSkipped = stream.GetSkippedCount();
+	unsigned long processed = 0, failed = 0;
+	double started = now();
+	while (now() - started < seconds)
+	{
+		int width, height;
+		if (!decoder.Decode(jpeg.data, jpeg.size, &pixels[0], pixelStride, &width, &height))
+		{
+			failed++;
+		}
+		else
+		{
+			frame->result.sequence = jpeg.sequence;
+			frame->result.timestamp = jpeg.arrival;
+			pipeline.Process(frame, &pixels[0], pixelStride, width, height);
+			for (double busy = now() + work; now() < busy; )
+				;
+			ages.push_back(now() - jpeg.arrival);
+			processed++;
+		}
+		if (!stream.WaitForFrame(&jpeg))
+			break;
+	}
+	double elapsed = now() - started;
+	unsigned long received = stream.GetReceivedCount() - firstReceived;
+	unsigned long dropped = stream.GetDroppedCount() - firstDropped;
+	unsigned long skipped = stream.GetSkippedCount() - firstSkipped;
+	stream.Stop();
+
+	fprintf(stderr, "%lu frames received in %.3f s, %.1f frames/s\n", received, elapsed, received / elapsed);
+	fprintf(stderr, "%lu processed (%.1f frames/s), %lu dropped for newer frames, %lu too big, %lu didn't decode\n",
+			processed, processed / elapsed, dropped, skipped, failed);
+	double p50 = percentile(ages, 0.5) * 1000;
+	double p99 = percentile(ages, 0.99) * 1000;
+	double max = ages.empty() ? 0 : *max_element(ages.begin(), ages.end()) * 1000;
+	fprintf(stderr, "frame age when done (ms): p50 %.3f, p99 %.3f, max %.3f\n", p50, p99, max);
+
+	delete ycbcrThreshold;
+	delete frame;
+	return 0;
+}
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * Turns a binary log written by TelemetryLog back into text or CSV on a PC.
+ *
+ * Build from the top of the project:
+ *   g++ -O2 -I. -o TelemetryDecode tools/TelemetryDecode.cpp
+ *
+ * Usage:
+ *   TelemetryDecode [--csv] FILE
+ *
+ * FILE can be - to read a log as it streams in, for example from `nc -l 5800 | TelemetryDecode -`.
+ * Text output has one line per record with the time, the event name and its named values.
+ * CSV output has the columns time, event, value0, value1, value2. Logs written by the cRIO are
+ * big endian and are swapped to the PC's byte order, which the first word of the log shows.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include "TelemetryLog.h"
+#include "TelemetryEvents.h"
+#include <stdio.h>
+#include <string.h>
+
+static bool swapBytes;
+
+//reverses the bytes of a value if the log was written in the other byte order
+static void fix(void *value, int size)
+{
+	if (!swapBytes)
+		return;
+	unsigned char *bytes = (unsigned char *) value;
+	for (int i = 0; i < size / 2; i++)
+	{
+		unsigned char b = bytes[i];
+		bytes[i] = bytes[size - 1 - i];
+		bytes[size - 1 - i] = b;
+	}
+}
+
+static const char *eventName(int event, char *unknown)
+{
+	if (event == TELEMETRY_DROPPED)
+		return "dropped";
+	if (event < TELEMETRY_EVENT_COUNT)
+		return telemetryEvents[event].name;
+	sprintf(unknown, "event_%d", event);
+	return unknown;
+}
+
+static const char *valueName(int event, int value)
+{
+	if (event == TELEMETRY_DROPPED)
+		return value == 0 ? "records" : NULL;
+	if (event < TELEMETRY_EVENT_COUNT)
+		return telemetryEvents[event].values[value];
+	return NULL;
+}
+
+int main(int argc, char **argv)
+{
+	bool csv = false;
+	const char *path = NULL;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--csv") == 0)
+			csv = true;
+		else
+			path = argv[i];
+	}
+	if (!path)
+	{
+		fprintf(stderr, "usage: %s [--csv] FILE\n", argv[0]);
+		return 1;
+	}
+	FILE *in = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+	if (!in)
+	{
+		fprintf(stderr, "can't read %s\n", path);
+		return 1;
+	}
+
+	unsigned int header[4];
+	if (fread(header, sizeof(header), 1, in) != 1)
+	{
+		fprintf(stderr, "%s is empty\n", path);
+		return 1;
+	}
+	swapBytes = header[0] != TELEMETRY_MAGIC;
+	for (int i = 0; i < 4; i++)
+		fix(&header[i], sizeof(header[i]));
+	if (header[0] != TELEMETRY_MAGIC || header[1] != TELEMETRY_VERSION || header[2] != sizeof(TelemetryRecord))
+	{
+		fprintf(stderr, "%s is not a version %d telemetry log\n", path, TELEMETRY_VERSION);
+		return 1;
+	}
+
+	if (csv)
+		printf("time,event,value0,value1,value2\n");
+	TelemetryRecord record;
+	unsigned long records = 0;
+	while (fread(&record, sizeof(record), 1, in) == 1)
+	{
+		char unknown[32];
+		fix(&record.timestamp, sizeof(record.timestamp));
+		fix(&record.event, sizeof(record.event));
+		fix(&record.valueCount, sizeof(record.valueCount));
+		int count = record.valueCount < TELEMETRY_VALUES ? record.valueCount : TELEMETRY_VALUES;
+		for (int i = 0; i < TELEMETRY_VALUES; i++)
+			fix(&record.values[i], sizeof(record.values[i]));
+		const char *name = eventName(record.event, unknown);
+		records++;
+
+		if (csv)
+		{
+			printf("%.6f,%s", record.timestamp, name);
+			for (int i = 0; i < TELEMETRY_VALUES; i++)
+			{
+				if (i < count)
+					printf(",%g", record.values[i]);
+				else
+					printf(",");
+			}
+			printf("\n");
+			continue;
+		}
+		printf("%12.6f  %-20s", record.timestamp, name);
+		for (int i = 0; i < count; i++)
+		{
+			const char *label = valueName(record.event, i);
+			if (label)
+				printf("  %s=%g", label, record.values[i]);
+			else
+				printf("  %g", record.values[i]);
+		}
+		printf("\n");
+	}
+	fprintf(stderr, "%lu records\n", records);
+	return 0;
+}
+
+#endif
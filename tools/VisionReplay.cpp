@@ -0,0 +1,500 @@
+/**
+ * Runs the vision pipeline over a directory of saved camera frames on a PC, with no camera or
+ * cRIO, and reports how long each step takes and what was found in each frame.
+ *
+ * Build from the top of the project:
+ *   g++ -O2 -DCOUNT_ALLOCATIONS -I. -o VisionReplay tools/VisionReplay.cpp HSVThreshold.cpp \
+ *       ParticleLabeler.cpp VisionPipeline.cpp VisionEngine.cpp YCbCrThreshold.cpp JpegFrameDecoder.cpp \
+ *       TargetTracker.cpp VisionCalibration.cpp AllocationCounter.cpp -ljpeg -lpthread
+ *
+ * Usage:
+ *   VisionReplay [--loops N] [--threads N [--drop-stale]] [--scale N] [--ycbcr] [--track] [--coarse]
+ *                [--targets] [--json FILE] DIR_OR_JPEG...
+ *
+ * Every frame is decoded from memory and run through the same steps as Vision2823::Run, N times
+ * over (10 by default), with tracking and coarse to fine search turned on if asked. --targets
+ * follows the high goal across the frames with a TargetTracker, in the order given, as Vision2823
+ * does, and reports the track it settles on instead of each frame's last goal. The frames are
+ * stamped 1/30 s apart for it, as the camera sends them, and a goal the track coasted through
+ * without seeing is marked "coasted". --scale
+ * decodes the JPEGs 2, 4 or 8 times smaller, and --ycbcr skips the color conversion and
+ * thresholds the YCbCr pixels with a YCbCrThreshold. The latency
+ * of each step (p50, p99, max) and the frame rate go to stderr; when a tracked search loses the
+ * goal and the whole frame is searched again, as VisionPipeline::Process does, both passes
+ * count towards each step. The goals and particle scores
+ * found in each frame are written as JSON to FILE, or stdout.
+ *
+ * With --threads the frames are run through a VisionEngine with that many workers instead, which
+ * keeps every frame (or drops stale ones with --drop-stale). The steps overlap there, so only the
+ * decode time and the total time from capture to publish are reported.
+ *
+ * Workbench builds every source file in the project for the cRIO, so this file is left empty
+ * when _WRS_KERNEL is defined.
+ */
+#ifndef _WRS_KERNEL
+
+#include "VisionPipeline.h"
+#include "VisionEngine.h"
+#include "JpegFrameDecoder.h"
+#include "AllocationCounter.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+//Steps that are timed separately
+enum Stage { STAGE_DECODE, STAGE_THRESHOLD, STAGE_LABEL, STAGE_SCORE, STAGE_TOTAL, STAGE_COUNT };
+static const char *stageNames[STAGE_COUNT] = { "decode", "threshold", "label", "score", "total" };
+
+//Seconds between the frames as they are stamped for the TargetTracker, the Axis camera's 30
+//frames/s, so tracks coast for as many frames as they would on the robot however fast this runs
+#define REPLAY_FRAME_PERIOD (1.0 / 30)
+
+struct Recording {
+	string name;
+	string jsonName;		//name quoted for the JSON output, so writing a frame doesn't allocate
+	vector<unsigned char> jpeg;
+};
+
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static string jsonString(const string &text)
+{
+	string quoted = "\"";
+	for (unsigned i = 0; i < text.size(); i++)
+	{
+		if (text[i] == '"' || text[i] == '\\')
+			quoted += '\\';
+		quoted += text[i];
+	}
+	return quoted + "\"";
+}
+
+static bool hasJpegExtension(const string &name)
+{
+	size_t dot = name.rfind('.');
+	if (dot == string::npos)
+		return false;
+	string ext = name.substr(dot + 1);
+	return strcasecmp(ext.c_str(), "jpg") == 0 || strcasecmp(ext.c_str(), "jpeg") == 0;
+}
+
+static bool readFile(const string &path, vector<unsigned char> *data)
+{
+	FILE *fp = fopen(path.c_str(), "rb");
+	if (!fp)
+		return false;
+	fseek(fp, 0, SEEK_END);
+	long size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	data->resize(size);
+	bool ok = size > 0 && fread(&(*data)[0], 1, size, fp) == (size_t) size;
+	fclose(fp);
+	return ok;
+}
+
+/**
+ * Adds a JPEG file, or every JPEG in a directory in name order, to the recordings.
+ */
+static void addRecordings(const string &path, vector<Recording> *recordings)
+{
+	struct stat info;
+	if (stat(path.c_str(), &info) != 0)
+	{
+		fprintf(stderr, "can't read %s\n", path.c_str());
+		return;
+	}
+	vector<string> files;
+	if (S_ISDIR(info.st_mode))
+	{
+		DIR *dir = opendir(path.c_str());
+		struct dirent *entry;
+		while (dir && (entry = readdir(dir)) != NULL)
+		{
+			if (hasJpegExtension(entry->d_name))
+				files.push_back(path + "/" + entry->d_name);
+		}
+		if (dir)
+			closedir(dir);
+		sort(files.begin(), files.end());
+	}
+	else
+	{
+		files.push_back(path);
+	}
+	for (unsigned i = 0; i < files.size(); i++)
+	{
+		Recording recording;
+		recording.name = files[i];
+		recording.jsonName = jsonString(files[i]);
+		if (readFile(files[i], &recording.jpeg))
+			recordings->push_back(recording);
+		else
+			fprintf(stderr, "can't read %s\n", files[i].c_str());
+	}
+}
+
+static double percentile(vector<double> &samples, double fraction)
+{
+	if (samples.empty())
+		return 0;
+	sort(samples.begin(), samples.end());
+	unsigned index = (unsigned) (fraction * (samples.size() - 1) + 0.5);
+	return samples[index];
+}
+
+static void writeFrameJson(FILE *out, const Recording &recording, VisionFrame *frame, bool first)
+{
+	VisionResult *result = &frame->result;
+	fprintf(out, "%s    {\"file\": %s, \"width\": %d, \"height\": %d, \"tracked\": %s,\n",
+			first ? "" : ",\n", recording.jsonName.c_str(), frame->width, frame->height, result->tracked ? "true" : "false");
+	fprintf(out, "     \"highGoal\": ");
+	if (result->isHighGoal)
+	{
+		fprintf(out, "{\"x\": %d, \"y\": %d, \"width\": %d, \"height\": %d, \"centerXNormal\": %.4f, "
+				"\"centerYNormal\": %.4f, \"distance\": %.3f, \"distance2\": %.3f",
+				result->highX, result->highY, result->highWidth, result->highHeight, result->highCenterXNormal,
+				result->highCenterYNormal, result->highDistance, result->highDistance2);
+		if (result->highTrackId)
+			fprintf(out, ", \"track\": %d, \"confidence\": %.3f, \"age\": %.3f, \"misses\": %d, \"coasted\": %s",
+					result->highTrackId, result->highConfidence, result->highAge, result->highMisses,
+					result->highMisses > 0 ? "true" : "false");
+		fprintf(out, "},\n");
+	}
+	else
+		fprintf(out, "null,\n");
+	fprintf(out, "     \"midGoal\": ");
+	if (result->isMidGoal)
+		fprintf(out, "{\"centerX\": %.4f, \"centerY\": %.4f, \"distance\": %.3f, \"distance2\": %.3f},\n",
+				result->midCenterX, result->midCenterY, result->midDistance, result->midDistance2);
+	else
+		fprintf(out, "null,\n");
+	fprintf(out, "     \"particles\": [");
+	for (int i = 0; i < frame->particleCount; i++)
+	{
+		ParticleReport *report = frame->labeler.GetParticle(i);
+		Scores *scores = &frame->scores[i];
+		fprintf(out, "%s\n       {\"left\": %d, \"top\": %d, \"width\": %d, \"height\": %d, \"area\": %.1f, "
+				"\"rectangularity\": %.2f, \"xEdge\": %.2f, \"yEdge\": %.2f, \"aspectRatio\": {",
+				i ? "," : "", report->boundingRect.left, report->boundingRect.top, report->boundingRect.width,
+				report->boundingRect.height, report->particleArea, scores->rectangularity, scores->xEdge, scores->yEdge);
+		for (int type = 0; type < TARGET_TYPES; type++)
+			fprintf(out, "%s\"%s\": %.2f", type ? ", " : "", targetDescriptors[type].name, scores->aspectRatio[type]);
+		if (scores->target == TARGET_NONE)
+			fprintf(out, "}, \"target\": null}");
+		else
+			fprintf(out, "}, \"target\": \"%s\"}", targetDescriptors[scores->target].name);
+	}
+	fprintf(out, "]}");
+}
+
+/**
+ * Feeds the recordings to a VisionEngine, loops times over. Capture only picks the next
+ * recording, the JPEG is decoded by the engine's workers. The first loop's results are written
+ * as JSON as they are published.
+ */
+class ReplaySource : public VisionSource
+{
+private:
+	struct ReplayFrame {
+		unsigned index;
+		double captureTime;
+		double decodeTime;
+		JpegFrameDecoder *decoder;	//each slot gets its own, since several are decoded at once
+	};
+	const vector<Recording> &recordings;
+	unsigned total, next;
+	FILE *json;
+	bool firstJson;
+
+public:
+	vector<double> samples[STAGE_COUNT];
+
+	int scale;
+	JpegPixelFormat format;
+
+	ReplaySource(const vector<Recording> &in_recordings, int loops, FILE *in_json) : recordings(in_recordings)
+	{
+		scale = 1;
+		format = JPEG_PIXELS_BGRA;
+		total = loops * recordings.size();
+		next = 0;
+		json = in_json;
+		firstJson = true;
+		for (int s = 0; s < STAGE_COUNT; s++)
+			samples[s].reserve(total);
+	}
+
+	virtual bool Capture(VisionEngineSlot *slot)
+	{
+		if (next == total)
+			return false;
+		ReplayFrame *replay = (ReplayFrame *) slot->data;
+		replay->index = next++;
+		replay->captureTime = now();
+		slot->frame.result.timestamp = next * REPLAY_FRAME_PERIOD;
+		return true;
+	}
+
+	virtual bool Decode(VisionEngineSlot *slot)
+	{
+		ReplayFrame *replay = (ReplayFrame *) slot->data;
+		double started = now();
+		const vector<unsigned char> &jpeg = recordings[replay->index % recordings.size()].jpeg;
+		bool ok = replay->decoder->Decode(&jpeg[0], jpeg.size(), slot->pixels, slot->pixelStride, &slot->width,
+				&slot->height);
+		replay->decodeTime = now() - started;
+		return ok;
+	}
+
+	virtual void Finished(VisionEngineSlot *slot)
+	{
+		ReplayFrame *replay = (ReplayFrame *) slot->data;
+		if (slot->dropped)
+			return;
+		samples[STAGE_DECODE].push_back(replay->decodeTime);
+		samples[STAGE_TOTAL].push_back(now() - replay->captureTime);
+		if (replay->index < recordings.size())
+		{
+			writeFrameJson(json, recordings[replay->index], &slot->frame, firstJson);
+			firstJson = false;
+		}
+	}
+
+	/**
+	 * Hangs the bookkeeping for one frame on an engine slot, before the engine is started.
+	 */
+	void Attach(VisionEngineSlot *slot)
+	{
+		ReplayFrame *replay = new ReplayFrame;
+		replay->decoder = new JpegFrameDecoder(MAX_IMAGE_WIDTH, MAX_IMAGE_HEIGHT);
+		replay->decoder->SetScale(scale);
+		replay->decoder->SetFormat(format);
+		slot->data = replay;
+	}
+
+	void Release(VisionEngineSlot *slot)
+	{
+		ReplayFrame *replay = (ReplayFrame *) slot->data;
+		delete replay->decoder;
+		delete replay;
+		slot->data = NULL;
+	}
+};
+
+int main(int argc, char **argv)
+{
+	int loops = 10;
+	int threads = 0;
+	bool track = false;
+	bool coarse = false;
+	bool targets = false;
+	bool dropStale = false;
+	int scale = 1;
+	bool ycbcr = false;
+	const char *jsonPath = NULL;
+	vector<Recording> recordings;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--loops") == 0 && i + 1 < argc)
+			loops = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--track") == 0)
+			track = true;
+		else if (strcmp(argv[i], "--coarse") == 0)
+			coarse = true;
+		else if (strcmp(argv[i], "--targets") == 0)
+			targets = true;
+		else if (strcmp(argv[i], "--drop-stale") == 0)
+			dropStale = true;
+		else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc)
+			scale = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--ycbcr") == 0)
+			ycbcr = true;
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+			jsonPath = argv[++i];
+		else
+			addRecordings(argv[i], &recordings);
+	}
+	if (recordings.empty() || loops < 1 || threads < 0)
+	{
+		fprintf(stderr, "usage: %s [--loops N] [--threads N [--drop-stale]] [--scale N] [--ycbcr] [--track] [--coarse] "
+				"[--targets] [--json FILE] DIR_OR_JPEG...\n", argv[0]);
+		return 1;
+	}
+
+	VisionPipeline pipeline;
+	TargetTracker tracker;
+	VisionFrame *frame = new VisionFrame();
+	JpegFrameDecoder decoder(MAX_IMAGE_WIDTH, MAX_IMAGE_HEIGHT);
+	YCbCrThreshold *ycbcrThreshold = ycbcr ? new YCbCrThreshold(pipeline.GetThreshold()) : NULL;
+	JpegPixelFormat format = ycbcr ? JPEG_PIXELS_YCBCR : JPEG_PIXELS_BGRA;
+	int pixelStride = MAX_IMAGE_WIDTH * 4;
+	vector<unsigned char> pixels(MAX_IMAGE_WIDTH * MAX_IMAGE_HEIGHT * 4);
+	vector<double> samples[STAGE_COUNT];
+	for (int s = 0; s < STAGE_COUNT; s++)
+		samples[s].reserve(loops * recordings.size());
+	pipeline.SetTracking(track);
+	pipeline.SetCoarseToFine(coarse);
+	pipeline.SetYCbCrThreshold(ycbcrThreshold);
+	decoder.SetScale(scale);
+	decoder.SetFormat(format);
+
+	//drop anything that won't decode up front so every loop sees the same frames
+	for (unsigned i = 0; i < recordings.size(); )
+	{
+		int width, height;
+		const vector<unsigned char> &jpeg = recordings[i].jpeg;
+		if (decoder.Decode(&jpeg[0], jpeg.size(), &pixels[0], pixelStride, &width, &height))
+		{
+			i++;
+		}
+		else
+		{
+			fprintf(stderr, "skipping %s, not a JPEG of at most %dx%d after scaling\n", recordings[i].name.c_str(),
+					MAX_IMAGE_WIDTH, MAX_IMAGE_HEIGHT);
+			recordings.erase(recordings.begin() + i);
+		}
+	}
+	if (recordings.empty())
+		return 1;
+
+	FILE *json = jsonPath ? fopen(jsonPath, "w") : stdout;
+	if (!json)
+	{
+		fprintf(stderr, "can't write %s\n", jsonPath);
+		return 1;
+	}
+	fprintf(json, "{\n  \"frames\": [\n");
+
+	unsigned long allocations = 0;
+	unsigned long dropped = 0;
+	double started = now();
+	if (threads > 0)
+	{
+		//decode, threshold, label and score overlap, so only whole frame times are measured
+		ReplaySource source(recordings, loops, json);
+		source.scale = scale;
+		source.format = format;
+		VisionEngine *engine = new VisionEngine(&source, threads, dropStale ? VISION_DROP_STALE : VISION_KEEP_ALL);
+		engine->SetTracking(track);
+		engine->SetCoarseToFine(coarse);
+		engine->SetTargetTracking(targets);
+		engine->SetYCbCrThreshold(ycbcrThreshold);
+		for (int i = 0; i < engine->GetSlotCount(); i++)
+			source.Attach(engine->GetSlot(i));
+		started = now();
+		unsigned long allocationsBefore = AllocationCounter::Count();
+		if (!engine->Start())
+		{
+			fprintf(stderr, "can't start %d threads\n", threads);
+			return 1;
+		}
+		engine->WaitUntilDone();
+		allocations = AllocationCounter::Count() - allocationsBefore;
+		engine->Stop();
+		dropped = engine->GetDroppedCount();
+		for (int s = 0; s < STAGE_COUNT; s++)
+			samples[s].swap(source.samples[s]);
+		for (int i = 0; i < engine->GetSlotCount(); i++)
+			source.Release(engine->GetSlot(i));
+		delete engine;
+	}
+	else
+	{
+		unsigned long sequence = 0;
+		for (int loop = 0; loop < loops; loop++)
+		{
+			for (unsigned i = 0; i < recordings.size(); i++)
+			{
+				int width, height;
+				double t0 = now();
+				const vector<unsigned char> &jpeg = recordings[i].jpeg;
+				decoder.Decode(&jpeg[0], jpeg.size(), &pixels[0], pixelStride, &width, &height);
+				unsigned long allocationsBefore = AllocationCounter::Count();
+				double t1 = now();
+				frame->result.sequence = ++sequence;
+				frame->result.timestamp = sequence * REPLAY_FRAME_PERIOD;
+				double threshold = 0, label = 0, score = 0;
+				//once through, and again over the whole frame when a tracked search lost the goal,
+				//as Process() does
+				for (int pass = 0; pass < 2; pass++)
+				{
+					if (pass > 0 && !(frame->result.tracked && !frame->result.isHighGoal))
+						break;
+					double t2 = now();
+					pipeline.Threshold(frame, &pixels[0], pixelStride, width, height);
+					double t3 = now();
+					pipeline.Label(frame);
+					double t4 = now();
+					pipeline.Score(frame);
+					threshold += t3 - t2;
+					label += t4 - t3;
+					score += now() - t4;
+				}
+				if (targets)
+				{
+					double t5 = now();
+					tracker.Update(frame->highDetections, frame->highDetectionCount, frame->result.timestamp);
+					tracker.Report(&frame->result, frame->width, frame->height);
+					score += now() - t5;
+				}
+				double t6 = now();
+				allocations += AllocationCounter::Count() - allocationsBefore;
+
+				samples[STAGE_DECODE].push_back(t1 - t0);
+				samples[STAGE_THRESHOLD].push_back(threshold);
+				samples[STAGE_LABEL].push_back(label);
+				samples[STAGE_SCORE].push_back(score);
+				samples[STAGE_TOTAL].push_back(t6 - t0);
+				if (loop == 0)
+					writeFrameJson(json, recordings[i], frame, i == 0);
+			}
+		}
+	}
+	double elapsed = now() - started;
+
+	unsigned frames = samples[STAGE_TOTAL].size();
+	fprintf(json, "\n  ],\n  \"frameCount\": %u,\n  \"droppedFrames\": %lu,\n  \"threads\": %d,\n  \"fps\": %.1f,\n"
+			"  \"pipelineAllocations\": %lu,\n  \"stages\": {", frames, dropped, threads, frames / elapsed, allocations);
+	fprintf(stderr, "%u frames (%lu dropped) in %.3f s, %.1f frames/s, %lu allocations in the pipeline%s\n", frames,
+			dropped, elapsed, frames / elapsed, allocations,
+			AllocationCounter::Enabled() ? "" : " (not counted, build with COUNT_ALLOCATIONS)");
+	fprintf(stderr, "%-10s %10s %10s %10s  (ms)\n", "stage", "p50", "p99", "max");
+	bool firstStage = true;
+	for (int s = 0; s < STAGE_COUNT; s++)
+	{
+		if (samples[s].empty())
+			continue;
+		double p50 = percentile(samples[s], 0.5) * 1000;
+		double p99 = percentile(samples[s], 0.99) * 1000;
+		double max = percentile(samples[s], 1.0) * 1000;
+		fprintf(stderr, "%-10s %10.3f %10.3f %10.3f\n", stageNames[s], p50, p99, max);
+		fprintf(json, "%s\n    \"%s\": {\"p50Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f}", firstStage ? "" : ",",
+				stageNames[s], p50, p99, max);
+		firstStage = false;
+	}
+	fprintf(json, "\n  }\n}\n");
+	if (json != stdout)
+		fclose(json);
+	delete frame;
+	delete ycbcrThreshold;
+	return 0;
+}
+
+#endif